@@ -0,0 +1,197 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+
+#include "imgui.h"
+#include "imgui_internal.h"
+#include "implot.h"
+#include "implot_internal.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CANDLE_RENDERER_X86 1
+#endif
+
+// Plot-to-pixel mapping of a linear (or time) ImPlot axis, the same arithmetic as
+// ImPlotAxis::PlotToPixels without the per-call check for a custom scale.
+struct AxisTransform
+{
+    double min;
+    double scale;
+    double pixel_min;
+
+    // std::nullopt for log, symlog and custom scales, which need the axis' own transform.
+    static std::optional<AxisTransform> of(const ImPlotAxis &axis)
+    {
+        if (axis.TransformForward != nullptr)
+            return std::nullopt;
+        return AxisTransform{ .min = axis.Range.Min, .scale = axis.ScaleToPixel, .pixel_min = axis.PixelMin };
+    }
+
+    float operator()(double value) const { return static_cast<float>(pixel_min + scale * (value - min)); }
+
+    // The plot value at a pixel position, the inverse of operator().
+    double toPlot(double pixel) const { return min + (pixel - pixel_min) / scale; }
+};
+
+// Batch versions of AxisTransform::operator(). The vector paths keep the scalar order of
+// operations (no FMA), so every path produces bit-identical pixels.
+inline void transformToPixelsScalar(const double *values, float *out, size_t count, AxisTransform axis)
+{
+    for (size_t i = 0; i < count; ++i)
+        out[i] = axis(values[i]);
+}
+
+#ifdef CANDLE_RENDERER_X86
+__attribute__((target("sse4.1"))) inline void transformToPixelsSSE41(const double *values, float *out, size_t count,
+                                                                     AxisTransform axis)
+{
+    const __m128d min = _mm_set1_pd(axis.min);
+    const __m128d scale = _mm_set1_pd(axis.scale);
+    const __m128d pixel_min = _mm_set1_pd(axis.pixel_min);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128d lo = _mm_add_pd(pixel_min, _mm_mul_pd(scale, _mm_sub_pd(_mm_loadu_pd(values + i), min)));
+        __m128d hi = _mm_add_pd(pixel_min, _mm_mul_pd(scale, _mm_sub_pd(_mm_loadu_pd(values + i + 2), min)));
+        _mm_storeu_ps(out + i, _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)));
+    }
+    transformToPixelsScalar(values + i, out + i, count - i, axis);
+}
+
+__attribute__((target("avx2"))) inline void transformToPixelsAVX2(const double *values, float *out, size_t count,
+                                                                  AxisTransform axis)
+{
+    const __m256d min = _mm256_set1_pd(axis.min);
+    const __m256d scale = _mm256_set1_pd(axis.scale);
+    const __m256d pixel_min = _mm256_set1_pd(axis.pixel_min);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256d lo = _mm256_add_pd(pixel_min, _mm256_mul_pd(scale, _mm256_sub_pd(_mm256_loadu_pd(values + i), min)));
+        __m256d hi = _mm256_add_pd(pixel_min, _mm256_mul_pd(scale, _mm256_sub_pd(_mm256_loadu_pd(values + i + 4), min)));
+        _mm256_storeu_ps(out + i, _mm256_set_m128(_mm256_cvtpd_ps(hi), _mm256_cvtpd_ps(lo)));
+    }
+    transformToPixelsScalar(values + i, out + i, count - i, axis);
+}
+#endif
+
+// Picks the widest instruction set the CPU supports, once.
+inline void transformToPixels(const double *values, float *out, size_t count, AxisTransform axis)
+{
+    using Kernel = void (*)(const double *, float *, size_t, AxisTransform);
+    static const Kernel kernel = []() -> Kernel {
+#ifdef CANDLE_RENDERER_X86
+        if (__builtin_cpu_supports("avx2"))
+            return transformToPixelsAVX2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return transformToPixelsSSE41;
+#endif
+        return transformToPixelsScalar;
+    }();
+    kernel(values, out, count, axis);
+}
+
+// Index range [first, last) of the candles in sorted xs that can reach into [min, max] with
+// bodies half_width wide, padded by one candle on each side so partially visible candles at the
+// edges are never dropped by rounding.
+struct VisibleRange
+{
+    size_t first;
+    size_t last;
+
+    static VisibleRange of(const double *xs, size_t count, double min, double max, double half_width)
+    {
+        size_t first = std::lower_bound(xs, xs + count, min - half_width) - xs;
+        size_t last = std::upper_bound(xs + first, xs + count, max + half_width) - xs;
+        return { .first = first > 0 ? first - 1 : 0, .last = std::min(last + 1, count) };
+    }
+
+    size_t size() const { return last - first; }
+};
+
+// Emits candlesticks as raw quads: a one pixel wide wick from low to high and a body from open to
+// close, both in the candle's colour. Candles go through in chunks small enough for the pixel
+// columns to stay in cache between the transform and the vertex writes, and every chunk is a
+// single PrimReserve() instead of an AddLine() and an AddRectFilled() per candle.
+class CandleRenderer
+{
+public:
+    static constexpr size_t kChunkSize = 2048;
+    static constexpr int kVerticesPerCandle = 8;
+    static constexpr int kIndicesPerCandle = 12;
+
+    struct Columns
+    {
+        const double *xs;
+        const double *opens;
+        const double *closes;
+        const double *lows;
+        const double *highs;
+
+        Columns from(size_t first) const
+        {
+            return { xs + first, opens + first, closes + first, lows + first, highs + first };
+        }
+    };
+
+    // half_width is in plot units along x.
+    void draw(ImDrawList &draw_list, AxisTransform x_axis, AxisTransform y_axis, const Columns &candles, size_t count,
+              double half_width, ImU32 bull_color, ImU32 bear_color)
+    {
+        const float half_width_px = static_cast<float>(half_width * x_axis.scale);
+        for (size_t start = 0; start < count; start += kChunkSize) {
+            size_t n = std::min(kChunkSize, count - start);
+            transformToPixels(candles.xs + start, x_.data(), n, x_axis);
+            transformToPixels(candles.opens + start, open_.data(), n, y_axis);
+            transformToPixels(candles.closes + start, close_.data(), n, y_axis);
+            transformToPixels(candles.lows + start, low_.data(), n, y_axis);
+            transformToPixels(candles.highs + start, high_.data(), n, y_axis);
+
+            draw_list.PrimReserve(static_cast<int>(n) * kIndicesPerCandle, static_cast<int>(n) * kVerticesPerCandle);
+            for (size_t i = 0; i < n; ++i) {
+                bool bear = candles.opens[start + i] > candles.closes[start + i];
+                ImU32 color = bear ? bear_color : bull_color;
+                // Matches AddLine(), which strokes the pixel centre line x + 0.5 one pixel wide.
+                addQuad(draw_list, ImVec2(x_[i], high_[i]), ImVec2(x_[i] + 1.0f, low_[i]), color);
+                addQuad(draw_list, ImVec2(x_[i] - half_width_px, open_[i]),
+                        ImVec2(x_[i] + half_width_px, close_[i]), color);
+            }
+        }
+    }
+
+private:
+    // PrimRect() without the per-call bookkeeping of the public API.
+    static void addQuad(ImDrawList &draw_list, ImVec2 a, ImVec2 c, ImU32 color)
+    {
+        const ImVec2 uv = draw_list._Data->TexUvWhitePixel;
+        auto index = static_cast<ImDrawIdx>(draw_list._VtxCurrentIdx);
+        ImDrawIdx *idx = draw_list._IdxWritePtr;
+        idx[0] = index;
+        idx[1] = static_cast<ImDrawIdx>(index + 1);
+        idx[2] = static_cast<ImDrawIdx>(index + 2);
+        idx[3] = index;
+        idx[4] = static_cast<ImDrawIdx>(index + 2);
+        idx[5] = static_cast<ImDrawIdx>(index + 3);
+
+        ImDrawVert *vtx = draw_list._VtxWritePtr;
+        vtx[0] = { a, uv, color };
+        vtx[1] = { ImVec2(c.x, a.y), uv, color };
+        vtx[2] = { c, uv, color };
+        vtx[3] = { ImVec2(a.x, c.y), uv, color };
+
+        draw_list._VtxWritePtr += 4;
+        draw_list._IdxWritePtr += 6;
+        draw_list._VtxCurrentIdx += 4;
+    }
+
+    std::array<float, kChunkSize> x_;
+    std::array<float, kChunkSize> open_;
+    std::array<float, kChunkSize> close_;
+    std::array<float, kChunkSize> low_;
+    std::array<float, kChunkSize> high_;
+};
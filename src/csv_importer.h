@@ -0,0 +1,291 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <future>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ohlc_series.h"
+#include "thread_pool.h"
+
+// Loads `time,open,high,low,close[,volume]` rows from a comma or tab separated file in the
+// background. Time is either Unix seconds or an ISO 8601 date with an optional time of day
+// (2019-01-02, 2019-01-02 14:30, 2019-01-02T14:30:00), always UTC. A header row and blank lines
+// are skipped. So are rows whose time is not after that of every row before them, which keeps the
+// series strictly increasing; they are counted on stderr like malformed rows. Volumes are kept
+// only if every row has one.
+//
+// The file is read in fixed-size chunks cut at the last newline, every chunk is parsed with
+// std::from_chars on a thread pool, and parsed chunks are appended to the series strictly in file
+// order. At most two chunks per thread are in flight, which bounds memory whatever the file size.
+class OhlcCsvImporter
+{
+public:
+    static constexpr size_t kChunkSize = 8 * 1024 * 1024;
+
+    // on_progress runs on the import thread after every merged chunk and once when done.
+    explicit OhlcCsvImporter(std::string path, std::function<void()> on_progress = {},
+                             unsigned threads = std::thread::hardware_concurrency())
+        : path_(std::move(path)), on_progress_(std::move(on_progress)), pool_(threads), thread_([this]() { run(); })
+    {
+    }
+
+    OhlcCsvImporter(const OhlcCsvImporter &) = delete;
+    OhlcCsvImporter &operator=(const OhlcCsvImporter &) = delete;
+
+    // Abandons an unfinished import.
+    ~OhlcCsvImporter()
+    {
+        cancelled_ = true;
+        thread_.join();
+    }
+
+    // Fraction of the file merged so far, for progress reporting from any thread.
+    float progress() const
+    {
+        uint64_t total = bytes_total_.load(std::memory_order_relaxed);
+        return total == 0 ? 0.0f : static_cast<float>(bytes_done_.load(std::memory_order_relaxed)) / total;
+    }
+
+    bool done() const { return done_.load(std::memory_order_acquire); }
+
+    struct Import
+    {
+        OhlcSeries series;
+        // one per bar, or empty
+        std::vector<double> volumes;
+    };
+
+    // The imported series once done(), std::nullopt if the import failed (reported on stderr).
+    std::optional<Import> take()
+    {
+        if (!done())
+            return std::nullopt;
+        return std::exchange(result_, std::nullopt);
+    }
+
+private:
+    struct Chunk
+    {
+        // volumes are NaN where a row has none
+        std::vector<double> xs, opens, highs, lows, closes, volumes;
+        size_t bad_rows = 0;
+        size_t unordered_rows = 0;
+        size_t bytes = 0;
+    };
+
+    void run()
+    {
+        std::ifstream in(path_, std::ios::binary);
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(path_, error);
+        if (!in || error) {
+            std::println(stderr, "Cannot open {}: {}", path_, error ? error.message() : std::strerror(errno));
+            finish();
+            return;
+        }
+        bytes_total_ = size;
+
+        OhlcSeries series;
+        std::vector<double> volumes;
+        size_t bad_rows = 0;
+        size_t unordered_rows = 0;
+        bool first_chunk = true;
+        std::string carry;
+        std::deque<std::future<Chunk>> in_flight;
+        auto mergeFront = [&]() {
+            Chunk chunk = in_flight.front().get();
+            in_flight.pop_front();
+            // A chunk only knows its own rows, so the ones not after the previous chunks' last
+            // are dropped here; they are a prefix, since a parsed chunk is strictly increasing.
+            size_t skip = 0;
+            if (!series.empty())
+                skip = std::upper_bound(chunk.xs.begin(), chunk.xs.end(), series.xs().back()) - chunk.xs.begin();
+            auto tail = [&](const std::vector<double> &column) { return std::span(column).subspan(skip); };
+            series.append(tail(chunk.xs), tail(chunk.opens), tail(chunk.highs), tail(chunk.lows), tail(chunk.closes));
+            std::ranges::copy(tail(chunk.volumes), std::back_inserter(volumes));
+            bad_rows += chunk.bad_rows;
+            unordered_rows += chunk.unordered_rows + skip;
+            bytes_done_.fetch_add(chunk.bytes, std::memory_order_relaxed);
+            notify();
+        };
+
+        while (in && !cancelled_) {
+            auto buffer = std::make_shared<std::string>(std::move(carry));
+            size_t start = buffer->size();
+            buffer->resize(start + kChunkSize);
+            in.read(buffer->data() + start, kChunkSize);
+            buffer->resize(start + static_cast<size_t>(in.gcount()));
+
+            // Whatever follows the last newline belongs to the next chunk's first row.
+            carry.clear();
+            if (in) {
+                size_t cut = buffer->rfind('\n');
+                cut = cut == std::string::npos ? 0 : cut + 1;
+                carry.assign(*buffer, cut);
+                buffer->resize(cut);
+            }
+
+            bool skip_header = std::exchange(first_chunk, false);
+            in_flight.push_back(pool_.submit([buffer, skip_header]() { return parse(*buffer, skip_header); }));
+            if (in_flight.size() >= 2 * pool_.size())
+                mergeFront();
+        }
+        while (!in_flight.empty())
+            mergeFront();
+
+        if (cancelled_) {
+            finish();
+            return;
+        }
+        if (bad_rows > 0)
+            std::println(stderr, "{}: skipped {} malformed rows", path_, bad_rows);
+        if (unordered_rows > 0)
+            std::println(stderr, "{}: skipped {} rows out of time order", path_, unordered_rows);
+        if (std::ranges::any_of(volumes, [](double volume) { return std::isnan(volume); }))
+            volumes.clear();
+        result_ = Import{ .series = std::move(series), .volumes = std::move(volumes) };
+        finish();
+    }
+
+    void finish()
+    {
+        done_.store(true, std::memory_order_release);
+        notify();
+    }
+
+    void notify()
+    {
+        if (on_progress_ && !cancelled_)
+            on_progress_();
+    }
+
+    static Chunk parse(std::string_view text, bool skip_header)
+    {
+        Chunk chunk;
+        chunk.bytes = text.size();
+        char delimiter = text.find('\t', 0) < text.find('\n', 0) ? '\t' : ',';
+        bool first_row = true;
+        double last_x = -std::numeric_limits<double>::infinity();
+        while (!text.empty()) {
+            size_t end = text.find('\n');
+            std::string_view row = text.substr(0, end);
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+            if (!row.empty() && row.back() == '\r')
+                row.remove_suffix(1);
+            if (row.empty())
+                continue;
+
+            std::array<double, 6> values;
+            if (!parseRow(row, delimiter, values)) {
+                if (!(skip_header && first_row))
+                    ++chunk.bad_rows;
+            } else if (!(values[0] > last_x)) {
+                // also catches a NaN time
+                ++chunk.unordered_rows;
+            } else {
+                last_x = values[0];
+                chunk.xs.push_back(values[0]);
+                chunk.opens.push_back(values[1]);
+                chunk.highs.push_back(values[2]);
+                chunk.lows.push_back(values[3]);
+                chunk.closes.push_back(values[4]);
+                chunk.volumes.push_back(values[5]);
+            }
+            first_row = false;
+        }
+        return chunk;
+    }
+
+    // Reads time, open, high, low, close and, if there is a sixth field, volume (NaN otherwise).
+    // Any further fields are ignored.
+    static bool parseRow(std::string_view row, char delimiter, std::array<double, 6> &values)
+    {
+        constexpr size_t kRequired = 5;
+        values[kRequired] = std::numeric_limits<double>::quiet_NaN();
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i == kRequired && row.empty())
+                break;
+            size_t end = row.find(delimiter);
+            if (end == std::string_view::npos && i + 1 < kRequired)
+                return false;
+            std::string_view field = row.substr(0, end);
+            row.remove_prefix(end == std::string_view::npos ? row.size() : end + 1);
+            bool ok = i == 0 ? parseTime(field, values[i]) : parseNumber(field, values[i]);
+            if (!ok)
+                return false;
+        }
+        return true;
+    }
+
+    static bool parseNumber(std::string_view field, double &value)
+    {
+        auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+        return ec == std::errc() && ptr == field.data() + field.size();
+    }
+
+    static bool parseTime(std::string_view field, double &seconds)
+    {
+        if (field.size() < 10 || field[4] != '-')
+            return parseNumber(field, seconds);
+
+        auto integer = [&](size_t offset, size_t length, int &value) {
+            if (offset + length > field.size())
+                return false;
+            auto [ptr, ec] = std::from_chars(field.data() + offset, field.data() + offset + length, value);
+            return ec == std::errc() && ptr == field.data() + offset + length;
+        };
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+        if (!integer(0, 4, year) || field[7] != '-' || !integer(5, 2, month) || !integer(8, 2, day))
+            return false;
+        if (field.size() > 10) {
+            if ((field[10] != ' ' && field[10] != 'T') || !integer(11, 2, hour) || field.size() < 16
+                || field[13] != ':' || !integer(14, 2, minute))
+                return false;
+            if (field.size() > 16 && (field[16] != ':' || !integer(17, 2, second) || field.size() != 19))
+                return false;
+        }
+
+        using namespace std::chrono;
+        year_month_day date{ std::chrono::year(year), std::chrono::month(month), std::chrono::day(day) };
+        if (!date.ok())
+            return false;
+        seconds = static_cast<double>(sys_seconds(sys_days(date)).time_since_epoch().count()
+                                      + hour * 3600 + minute * 60 + second);
+        return true;
+    }
+
+    std::string path_;
+    std::function<void()> on_progress_;
+    std::atomic<uint64_t> bytes_total_ = 0;
+    std::atomic<uint64_t> bytes_done_ = 0;
+    std::atomic<bool> cancelled_ = false;
+    std::atomic<bool> done_ = false;
+    std::optional<Import> result_;
+    ThreadPool pool_;
+    std::thread thread_;
+};
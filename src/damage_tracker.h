@@ -0,0 +1,214 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "imgui.h"
+#include "imgui_internal.h"
+
+// 64-bit running hash used to tell whether a draw list produced the same output as last frame.
+// Consumes input a word at a time; it only has to be collision-resistant enough for
+// frame-to-frame comparison, not cryptographically.
+class Fingerprint
+{
+public:
+    void add(const void *data, size_t size)
+    {
+        auto *bytes = static_cast<const unsigned char *>(data);
+        for (; size >= sizeof(uint64_t); bytes += sizeof(uint64_t), size -= sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, bytes, sizeof(word));
+            mix(word);
+        }
+        if (size > 0) {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes, size);
+            mix(word ^ (uint64_t(size) << 56));
+        }
+    }
+
+    template<typename T>
+        requires std::is_trivially_copyable_v<T>
+    void add(const T &value)
+    {
+        add(&value, sizeof(T));
+    }
+
+    uint64_t value() const { return hash_; }
+
+private:
+    void mix(uint64_t word)
+    {
+        hash_ = (hash_ ^ word) * 0x9E3779B97F4A7C15ull;
+        hash_ ^= hash_ >> 29;
+    }
+
+    uint64_t hash_ = 0xCBF29CE484222325ull;
+};
+
+// Works out which parts of the ImGui output changed since the previous frame by comparing every
+// draw list (one per window, plus the background and foreground lists) with its counterpart from
+// the previous frame. A changed list damages both where it was and where it is now.
+class DamageTracker
+{
+public:
+    static constexpr int kMaxRects = 4;
+
+    struct Damage
+    {
+        bool full = false;
+        std::vector<ImRect> rects; // display coordinates, disjoint, only when !full
+
+        bool empty() const { return !full && rects.empty(); }
+
+        // Share of the display that has to be redrawn, for diagnostics.
+        float coverage(ImVec2 display_size) const
+        {
+            if (full)
+                return 1.0f;
+            float area = 0.0f;
+            for (const ImRect &rect : rects)
+                area += rect.GetArea();
+            return std::min(1.0f, area / std::max(1.0f, display_size.x * display_size.y));
+        }
+    };
+
+    Damage update(const ImDrawData &draw_data)
+    {
+        std::vector<ListState> current;
+        current.reserve(draw_data.CmdLists.Size);
+        for (const ImDrawList *list : draw_data.CmdLists)
+            current.push_back(describe(*list));
+
+        Damage damage;
+        bool same_layout = valid_ && equal(draw_data.DisplayPos, display_pos_)
+                && equal(draw_data.DisplaySize, display_size_)
+                && equal(draw_data.FramebufferScale, framebuffer_scale_)
+                && current.size() == previous_.size();
+        // A different window order changes what overlaps what; not worth resolving.
+        for (size_t i = 0; same_layout && i < current.size(); ++i)
+            same_layout = current[i].list == previous_[i].list;
+
+        if (!same_layout) {
+            damage.full = true;
+        } else {
+            for (size_t i = 0; i < current.size(); ++i) {
+                if (current[i].hash == previous_[i].hash)
+                    continue;
+                addRect(damage.rects, previous_[i].bounds);
+                addRect(damage.rects, current[i].bounds);
+            }
+
+            // Past half the display, redrawing everything beats copying the rest forward.
+            ImRect display(draw_data.DisplayPos.x, draw_data.DisplayPos.y,
+                           draw_data.DisplayPos.x + draw_data.DisplaySize.x,
+                           draw_data.DisplayPos.y + draw_data.DisplaySize.y);
+            for (ImRect &rect : damage.rects)
+                rect.ClipWithFull(display);
+            std::erase_if(damage.rects, [](const ImRect &rect) { return rect.GetArea() <= 0.0f; });
+            if (damage.coverage(draw_data.DisplaySize) > 0.5f) {
+                damage.full = true;
+                damage.rects.clear();
+            }
+        }
+
+        previous_ = std::move(current);
+        display_pos_ = draw_data.DisplayPos;
+        display_size_ = draw_data.DisplaySize;
+        framebuffer_scale_ = draw_data.FramebufferScale;
+        valid_ = true;
+        return damage;
+    }
+
+    // The next update() reports full damage, e.g. when the previous output wasn't kept.
+    void invalidate() { valid_ = false; }
+
+private:
+    struct ListState
+    {
+        const ImDrawList *list;
+        uint64_t hash;
+        ImRect bounds;
+    };
+
+    static bool equal(ImVec2 a, ImVec2 b) { return a.x == b.x && a.y == b.y; }
+
+    static ListState describe(const ImDrawList &list)
+    {
+        Fingerprint fp;
+        fp.add(list.VtxBuffer.Data, list.VtxBuffer.size_in_bytes());
+        fp.add(list.IdxBuffer.Data, list.IdxBuffer.size_in_bytes());
+
+        ImRect clip(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (const ImDrawCmd &cmd : list.CmdBuffer) {
+            fp.add(cmd.ClipRect);
+            // Not GetTexID(): it asserts on textures the backend hasn't created yet.
+            fp.add(cmd.TexRef._TexData);
+            fp.add(cmd.TexRef._TexID);
+            fp.add(cmd.VtxOffset);
+            fp.add(cmd.IdxOffset);
+            fp.add(cmd.ElemCount);
+            fp.add(cmd.UserCallback);
+            fp.add(cmd.UserCallbackData);
+            if (cmd.ElemCount > 0)
+                clip.Add(ImRect(cmd.ClipRect));
+        }
+
+        ImRect bounds(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (const ImDrawVert &vertex : list.VtxBuffer)
+            bounds.Add(vertex.pos);
+        bounds.ClipWithFull(clip);
+
+        // Snap outwards to whole pixels, with a pixel of slack for anti-aliased fringes.
+        if (bounds.Min.x < bounds.Max.x && bounds.Min.y < bounds.Max.y) {
+            bounds = ImRect(std::floor(bounds.Min.x) - 1.0f, std::floor(bounds.Min.y) - 1.0f,
+                            std::ceil(bounds.Max.x) + 1.0f, std::ceil(bounds.Max.y) + 1.0f);
+        } else {
+            bounds = ImRect();
+        }
+
+        return ListState{ &list, fp.value(), bounds };
+    }
+
+    // Keeps the set disjoint by folding overlapping rectangles together, and collapses it to
+    // a single bounding rectangle once it grows past kMaxRects.
+    static void addRect(std::vector<ImRect> &rects, ImRect rect)
+    {
+        if (rect.GetArea() <= 0.0f)
+            return;
+
+        for (bool merged = true; merged;) {
+            merged = false;
+            for (auto it = rects.begin(); it != rects.end(); ++it) {
+                if (it->Overlaps(rect)) {
+                    rect.Add(*it);
+                    rects.erase(it);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        rects.push_back(rect);
+
+        if (rects.size() > kMaxRects) {
+            ImRect all = rects.front();
+            for (const ImRect &other : rects)
+                all.Add(other);
+            rects.assign(1, all);
+        }
+    }
+
+    std::vector<ListState> previous_;
+    ImVec2 display_pos_;
+    ImVec2 display_size_;
+    ImVec2 framebuffer_scale_;
+    bool valid_ = false;
+};
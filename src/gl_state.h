@@ -0,0 +1,228 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <optional>
+#include <utility>
+
+#include <GLES3/gl3.h>
+
+// Shadow copy of the bits of GL state the ImGui renderer binds and restores.
+// Each value is queried from the driver at most once between invalidate() calls and served from
+// the shadow afterwards; writes that would not change anything are dropped. Slint owns the
+// context in between rendering callbacks, so the cache has to be invalidated every time control
+// comes back from Slint.
+class GLStateCache
+{
+public:
+    struct Stats
+    {
+        int queries = 0;        // glGet*/glIsEnabled calls that reached the driver
+        int cached_reads = 0;   // reads answered from the shadow instead
+        int skipped_writes = 0; // binds/enables dropped because the value was already current
+
+        Stats &operator+=(const Stats &other)
+        {
+            queries += other.queries;
+            cached_reads += other.cached_reads;
+            skipped_writes += other.skipped_writes;
+            return *this;
+        }
+    };
+
+    void invalidate()
+    {
+        draw_framebuffer_.reset();
+        read_framebuffer_.reset();
+        texture_2d_.reset();
+        scissor_test_.reset();
+        scissor_box_.reset();
+        clear_color_.reset();
+    }
+
+    GLuint drawFramebuffer()
+    {
+        return read(draw_framebuffer_, [] { return queryBinding(GL_DRAW_FRAMEBUFFER_BINDING); });
+    }
+
+    void bindDrawFramebuffer(GLuint fbo)
+    {
+        write(draw_framebuffer_, fbo, [=] { glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo); });
+    }
+
+    GLuint readFramebuffer()
+    {
+        return read(read_framebuffer_, [] { return queryBinding(GL_READ_FRAMEBUFFER_BINDING); });
+    }
+
+    void bindReadFramebuffer(GLuint fbo)
+    {
+        write(read_framebuffer_, fbo, [=] { glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo); });
+    }
+
+    GLuint textureBinding2D()
+    {
+        return read(texture_2d_, [] { return queryBinding(GL_TEXTURE_BINDING_2D); });
+    }
+
+    void bindTexture2D(GLuint texture)
+    {
+        write(texture_2d_, texture, [=] { glBindTexture(GL_TEXTURE_2D, texture); });
+    }
+
+    bool scissorTest()
+    {
+        return read(scissor_test_, [] { return glIsEnabled(GL_SCISSOR_TEST) == GL_TRUE; });
+    }
+
+    void setScissorTest(bool enabled)
+    {
+        write(scissor_test_, enabled, [=] {
+            if (enabled)
+                glEnable(GL_SCISSOR_TEST);
+            else
+                glDisable(GL_SCISSOR_TEST);
+        });
+    }
+
+    using Box = std::array<GLint, 4>;
+
+    Box scissorBox()
+    {
+        return read(scissor_box_, [] {
+            Box box;
+            glGetIntegerv(GL_SCISSOR_BOX, box.data());
+            return box;
+        });
+    }
+
+    void setScissorBox(Box box)
+    {
+        write(scissor_box_, box, [=] { glScissor(box[0], box[1], box[2], box[3]); });
+    }
+
+    using Color = std::array<GLfloat, 4>;
+
+    Color clearColor()
+    {
+        return read(clear_color_, [] {
+            Color color;
+            glGetFloatv(GL_COLOR_CLEAR_VALUE, color.data());
+            return color;
+        });
+    }
+
+    void setClearColor(Color color)
+    {
+        write(clear_color_, color, [=] { glClearColor(color[0], color[1], color[2], color[3]); });
+    }
+
+    // Deleting a bound object implicitly rebinds 0, which the shadow has to follow.
+    void onFramebufferDeleted(GLuint fbo)
+    {
+        if (draw_framebuffer_ == fbo)
+            draw_framebuffer_ = 0;
+        if (read_framebuffer_ == fbo)
+            read_framebuffer_ = 0;
+    }
+
+    void onTextureDeleted(GLuint texture)
+    {
+        if (texture_2d_ == texture)
+            texture_2d_ = 0;
+    }
+
+    Stats takeStats() { return std::exchange(stats_, {}); }
+
+private:
+    static GLuint queryBinding(GLenum pname)
+    {
+        GLint value = 0;
+        glGetIntegerv(pname, &value);
+        return static_cast<GLuint>(value);
+    }
+
+    template<typename T, typename Query>
+    T read(std::optional<T> &shadow, Query query)
+    {
+        if (shadow) {
+            ++stats_.cached_reads;
+        } else {
+            ++stats_.queries;
+            shadow = query();
+        }
+        return *shadow;
+    }
+
+    template<typename T, typename Apply>
+    void write(std::optional<T> &shadow, T value, Apply apply)
+    {
+        if (shadow == value) {
+            ++stats_.skipped_writes;
+            return;
+        }
+        apply();
+        shadow = value;
+    }
+
+    std::optional<GLuint> draw_framebuffer_;
+    std::optional<GLuint> read_framebuffer_;
+    std::optional<GLuint> texture_2d_;
+    std::optional<bool> scissor_test_;
+    std::optional<Box> scissor_box_;
+    std::optional<Color> clear_color_;
+    Stats stats_;
+};
+
+// GL state belongs to whichever context is current on the calling thread.
+inline GLStateCache &glStateCache()
+{
+    thread_local GLStateCache cache;
+    return cache;
+}
+
+#define DEFINE_SCOPED_BINDING(StructName, Getter, Setter)                                          \
+    struct StructName                                                                              \
+    {                                                                                              \
+        GLuint saved_value = {};                                                                   \
+        StructName() = delete;                                                                     \
+        StructName(const StructName &) = delete;                                                   \
+        StructName &operator=(const StructName &) = delete;                                        \
+        StructName(GLuint new_value)                                                               \
+        {                                                                                          \
+            saved_value = glStateCache().Getter();                                                 \
+            glStateCache().Setter(new_value);                                                      \
+        }                                                                                          \
+        ~StructName()                                                                              \
+        {                                                                                          \
+            glStateCache().Setter(saved_value);                                                    \
+        }                                                                                          \
+    }
+
+DEFINE_SCOPED_BINDING(ScopedTextureBinding, textureBinding2D, bindTexture2D);
+DEFINE_SCOPED_BINDING(ScopedFrameBufferBinding, drawFramebuffer, bindDrawFramebuffer);
+DEFINE_SCOPED_BINDING(ScopedReadFrameBufferBinding, readFramebuffer, bindReadFramebuffer);
+
+// Sets a glPixelStorei parameter for the scope and puts the previous value back. Not shadowed:
+// the ImGui backend changes pixel store state behind the cache's back when it uploads textures.
+struct ScopedPixelStore
+{
+    GLenum pname;
+    GLint value;
+    GLint saved_value = 0;
+    ScopedPixelStore(const ScopedPixelStore &) = delete;
+    ScopedPixelStore &operator=(const ScopedPixelStore &) = delete;
+    ScopedPixelStore(GLenum name, GLint new_value) : pname(name), value(new_value)
+    {
+        glGetIntegerv(pname, &saved_value);
+        if (saved_value != value)
+            glPixelStorei(pname, value);
+    }
+    ~ScopedPixelStore()
+    {
+        if (saved_value != value)
+            glPixelStorei(pname, saved_value);
+    }
+};
@@ -0,0 +1,125 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <EGL/egl.h>
+
+// Runs GL jobs, in order, on a dedicated thread whose EGL context shares its objects (textures,
+// buffers, sync objects) with the context current on the thread that created it. Framebuffers
+// and vertex arrays are not shared between contexts, so everything that uses them has to stay
+// on the worker, including their deletion.
+class GLWorker
+{
+public:
+    // Returns nullptr unless the current context is an EGL OpenGL ES context and the display
+    // supports surfaceless contexts; callers are expected to keep rendering inline then.
+    static std::unique_ptr<GLWorker> create()
+    {
+        EGLDisplay display = eglGetCurrentDisplay();
+        EGLContext shared = eglGetCurrentContext();
+        if (display == EGL_NO_DISPLAY || shared == EGL_NO_CONTEXT)
+            return nullptr;
+
+        const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+        if (extensions == nullptr || std::strstr(extensions, "EGL_KHR_surfaceless_context") == nullptr)
+            return nullptr;
+
+        EGLint client_type = 0;
+        EGLint client_version = 0;
+        EGLint config_id = 0;
+        eglQueryContext(display, shared, EGL_CONTEXT_CLIENT_TYPE, &client_type);
+        eglQueryContext(display, shared, EGL_CONTEXT_CLIENT_VERSION, &client_version);
+        eglQueryContext(display, shared, EGL_CONFIG_ID, &config_id);
+        if (client_type != EGL_OPENGL_ES_API)
+            return nullptr;
+
+        const EGLint config_attribs[] = { EGL_CONFIG_ID, config_id, EGL_NONE };
+        EGLConfig config = nullptr;
+        EGLint config_count = 0;
+        if (!eglChooseConfig(display, config_attribs, &config, 1, &config_count) || config_count == 0)
+            return nullptr;
+
+        const EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, client_version, EGL_NONE };
+        EGLContext context = eglCreateContext(display, config, shared, context_attribs);
+        if (context == EGL_NO_CONTEXT)
+            return nullptr;
+
+        std::unique_ptr<GLWorker> worker(new GLWorker(display, context));
+        if (!worker->started_.get_future().get())
+            return nullptr;
+        return worker;
+    }
+
+    GLWorker(const GLWorker &) = delete;
+    GLWorker &operator=(const GLWorker &) = delete;
+
+    // Runs every job still queued, then releases the context.
+    ~GLWorker()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            quit_ = true;
+        }
+        wakeup_.notify_one();
+        thread_.join();
+        eglDestroyContext(display_, context_);
+    }
+
+    void post(std::function<void()> job)
+    {
+        {
+            std::lock_guard lock(mutex_);
+            jobs_.push_back(std::move(job));
+        }
+        wakeup_.notify_one();
+    }
+
+private:
+    GLWorker(EGLDisplay display, EGLContext context)
+        : display_(display), context_(context), thread_([this]() { run(); })
+    {
+    }
+
+    void run()
+    {
+        eglBindAPI(EGL_OPENGL_ES_API);
+        bool current = eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context_);
+        started_.set_value(current);
+
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock lock(mutex_);
+                wakeup_.wait(lock, [this]() { return quit_ || !jobs_.empty(); });
+                if (jobs_.empty())
+                    break;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            if (current)
+                job();
+        }
+
+        eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglReleaseThread();
+    }
+
+    EGLDisplay display_;
+    EGLContext context_;
+    std::promise<bool> started_;
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::deque<std::function<void()>> jobs_;
+    bool quit_ = false;
+    std::thread thread_;
+};
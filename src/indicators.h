@@ -0,0 +1,180 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "candle_renderer.h"
+#include "ohlc_series.h"
+
+// Technical indicators of one series, one value per bar in columns parallel to the bars:
+// simple and exponential moving averages, Bollinger bands, Wilder's RSI and a moving VWAP.
+//
+// update() only computes what changed since the previous call: the bars appended since, plus the
+// last bar seen before, which may have been revised in place while it was still forming. Moving
+// windows are summed a block of bars at a time (see windowSums()), which costs O(period) per block
+// on top of a pass over its bars and does not drift the way running sums over the whole history
+// would. EMA and RSI are recurrences and carry on from the previous bar's value. A streamed bar
+// thus costs O(period), and a freshly loaded series a single pass.
+class IndicatorSet
+{
+public:
+    struct Periods
+    {
+        size_t sma = 20;
+        size_t ema = 50;
+        size_t bollinger = 20;
+        double bollinger_width = 2.0;
+        size_t rsi = 14;
+        size_t vwap = 20;
+    };
+
+    IndicatorSet() = default;
+    explicit IndicatorSet(Periods periods) : periods_(periods) { }
+
+    const Periods &periods() const { return periods_; }
+    size_t size() const { return size_; }
+
+    // Values before an indicator's warm-up index are meaningless and must not be plotted.
+    const double *sma() const { return sma_.data(); }
+    size_t smaWarmup() const { return periods_.sma - 1; }
+    const double *ema() const { return ema_.data(); }
+    size_t emaWarmup() const { return periods_.ema - 1; }
+    const double *bollingerUpper() const { return upper_.data(); }
+    const double *bollingerLower() const { return lower_.data(); }
+    size_t bollingerWarmup() const { return periods_.bollinger - 1; }
+    const double *rsi() const { return rsi_.data(); }
+    size_t rsiWarmup() const { return periods_.rsi; }
+    const double *vwap() const { return vwap_.data(); }
+    size_t vwapWarmup() const { return periods_.vwap - 1; }
+
+    void reset() { size_ = 0; }
+
+    // Brings the indicators up to date with the first count bars of bars. Between calls bars may
+    // only have been appended or the last one revised; anything else needs a reset() first, though
+    // a series that shrank or starts at a different time is noticed. Without volumes every bar
+    // weighs the same in the VWAP.
+    void update(const CandleRenderer::Columns &bars, size_t count, const double *volumes = nullptr)
+    {
+        if (count < size_ || (size_ > 0 && count > 0 && bars.xs[0] != first_x_))
+            reset();
+        if (count == 0) {
+            size_ = 0;
+            return;
+        }
+        size_t from = size_ > 0 ? size_ - 1 : 0;
+        for (OhlcSeries::Column *column : { &sma_, &ema_, &upper_, &lower_, &rsi_, &vwap_, &gain_, &loss_ })
+            column->resize(count);
+        first_x_ = bars.xs[0];
+
+        for (size_t begin = from; begin < count; begin += kBlock)
+            updateWindows(bars, volumes, begin, std::min(kBlock, count - begin));
+        updateRecurrences(bars, from, count);
+        size_ = count;
+    }
+
+private:
+    static constexpr size_t kBlock = 256;
+    using Block = std::array<double, kBlock>;
+
+    // out[j] = the sum of value(i) over the window of bar i = begin + j, from prefix sums local to
+    // the block: one sequential add per bar, a vectorizable difference per output, and rounding
+    // bounded by the block length rather than by the length of the history.
+    template<typename F>
+    void windowSums(size_t period, size_t begin, size_t n, F value, double *out)
+    {
+        size_t start = begin + 1 - period;
+        prefix_.resize(n + period);
+        double sum = 0.0;
+        prefix_[0] = 0.0;
+        for (size_t m = 0; m + 1 < n + period; ++m)
+            prefix_[m + 1] = sum += value(start + m);
+        for (size_t j = 0; j < n; ++j)
+            out[j] = prefix_[j + period] - prefix_[j];
+    }
+
+    // Windowed indicators of bars [begin, begin + n); bars still warming up are skipped.
+    void updateWindows(const CandleRenderer::Columns &bars, const double *volumes, size_t begin, size_t n)
+    {
+        auto window = [&](size_t period, auto compute) {
+            size_t first = std::max(begin, period - 1);
+            if (first < begin + n)
+                compute(first, begin + n - first, static_cast<double>(period));
+        };
+        const double *closes = bars.closes;
+
+        window(periods_.sma, [&](size_t first, size_t count, double period) {
+            double *out = sma_.data() + first;
+            windowSums(periods_.sma, first, count, [&](size_t i) { return closes[i]; }, out);
+            for (size_t j = 0; j < count; ++j)
+                out[j] /= period;
+        });
+
+        window(periods_.bollinger, [&](size_t first, size_t count, double period) {
+            // moments of the closes shifted by one of them, which keeps the variance from cancelling
+            const double shift = closes[first];
+            Block sums, squares;
+            windowSums(periods_.bollinger, first, count, [&](size_t i) { return closes[i] - shift; }, sums.data());
+            windowSums(periods_.bollinger, first, count,
+                       [&](size_t i) { return (closes[i] - shift) * (closes[i] - shift); }, squares.data());
+            for (size_t j = 0; j < count; ++j) {
+                double mean = sums[j] / period;
+                double variance = std::max(squares[j] / period - mean * mean, 0.0);
+                double band = periods_.bollinger_width * std::sqrt(variance);
+                upper_[first + j] = shift + mean + band;
+                lower_[first + j] = shift + mean - band;
+            }
+        });
+
+        window(periods_.vwap, [&](size_t first, size_t count, double period) {
+            // typical price (high + low + close) / 3, weighted by volume
+            Block weighted, weights;
+            auto volume = [&](size_t i) { return volumes ? volumes[i] : 1.0; };
+            windowSums(periods_.vwap, first, count,
+                       [&](size_t i) { return (bars.highs[i] + bars.lows[i] + closes[i]) / 3.0 * volume(i); },
+                       weighted.data());
+            if (volumes)
+                windowSums(periods_.vwap, first, count, volume, weights.data());
+            else
+                std::fill(weights.begin(), weights.end(), period);
+            for (size_t j = 0; j < count; ++j)
+                vwap_[first + j] = weights[j] > 0.0 ? weighted[j] / weights[j] : closes[first + j];
+        });
+    }
+
+    void updateRecurrences(const CandleRenderer::Columns &bars, size_t from, size_t to)
+    {
+        const double *closes = bars.closes;
+        const double alpha = 2.0 / static_cast<double>(periods_.ema + 1);
+        const double rsi_smoothing = 1.0 / static_cast<double>(periods_.rsi);
+        for (size_t i = from; i < to; ++i) {
+            if (i == 0) {
+                ema_[0] = closes[0];
+                gain_[0] = loss_[0] = 0.0;
+                rsi_[0] = 50.0;
+                continue;
+            }
+            ema_[i] = ema_[i - 1] + alpha * (closes[i] - ema_[i - 1]);
+
+            // the first rsi period changes are averaged plainly, later ones smoothed Wilder's way
+            double change = closes[i] - closes[i - 1];
+            double weight = i <= periods_.rsi ? 1.0 / static_cast<double>(i) : rsi_smoothing;
+            gain_[i] = gain_[i - 1] + (std::max(change, 0.0) - gain_[i - 1]) * weight;
+            loss_[i] = loss_[i - 1] + (std::max(-change, 0.0) - loss_[i - 1]) * weight;
+            rsi_[i] = loss_[i] > 0.0 ? 100.0 - 100.0 / (1.0 + gain_[i] / loss_[i]) : gain_[i] > 0.0 ? 100.0 : 50.0;
+        }
+    }
+
+    Periods periods_;
+    size_t size_ = 0;
+    double first_x_ = 0.0;
+    OhlcSeries::Column sma_, ema_, upper_, lower_, rsi_, vwap_;
+    // Wilder's average gain and loss, the RSI's state at every bar
+    OhlcSeries::Column gain_, loss_;
+    std::vector<double> prefix_;
+};
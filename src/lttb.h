@@ -0,0 +1,174 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Largest-Triangle-Three-Buckets downsampling (Steinarsson): the first and last sample, plus from
+// every bucket in between the sample spanning the largest triangle with the point picked from the
+// bucket before and the mean of the bucket after. Unlike M4Decimator it is not pixel-exact; it
+// keeps the shape of the line within a fixed point budget, which is what overviews need.
+//
+// Buckets have a fixed width in samples instead of a fixed count, so appending samples leaves
+// earlier buckets alone: a bucket's pick is final once the bucket after it is complete, and only
+// the last two buckets are picked again when samples arrive. When the buckets outgrow the budget
+// their width doubles and everything is picked again, which keeps the amortized cost per appended
+// sample constant and the result between half and all of the budget. Results are memoized per
+// budget, so a few overview plots of different widths do not evict each other.
+class LttbDownsampler
+{
+public:
+    static constexpr size_t kMaxCached = 4;
+
+    struct Points
+    {
+        std::vector<double> xs;
+        std::vector<double> ys;
+
+        size_t size() const { return xs.size(); }
+    };
+
+    // At most max(budget, 3) points of the line through (xs[i], ys[i]). Between calls samples may
+    // only have been appended or the last one revised (version tells); anything else is noticed by
+    // a shrinking count or a different first x and starts over. Stays valid until the next call.
+    const Points &downsample(std::span<const double> xs, std::span<const double> ys, uint64_t version, size_t budget)
+    {
+        budget = std::max<size_t>(budget, 3);
+        Cache &cache = cacheFor(budget);
+        cache.last_used = ++uses_;
+        if (cache.count == xs.size() && cache.version == version && cache.valid)
+            return cache.points;
+        update(cache, xs, ys, budget);
+        cache.count = xs.size();
+        cache.version = version;
+        cache.valid = true;
+        return cache.points;
+    }
+
+private:
+    struct Cache
+    {
+        size_t budget = 0;
+        uint64_t last_used = 0;
+        bool valid = false;
+        size_t count = 0;
+        uint64_t version = 0;
+        double first_x = 0.0;
+        // samples per bucket; bucket k covers [1 + k * width, 1 + (k + 1) * width)
+        size_t width = 0;
+        // the final picks of the leading buckets
+        std::vector<size_t> picked;
+        Points points;
+    };
+
+    Cache &cacheFor(size_t budget)
+    {
+        auto it = std::find_if(caches_.begin(), caches_.end(), [&](const Cache &c) { return c.budget == budget; });
+        if (it != caches_.end())
+            return *it;
+        if (caches_.size() == kMaxCached)
+            caches_.erase(std::min_element(caches_.begin(), caches_.end(),
+                                           [](const Cache &a, const Cache &b) { return a.last_used < b.last_used; }));
+        Cache &cache = caches_.emplace_back();
+        cache.budget = budget;
+        return cache;
+    }
+
+    static void update(Cache &cache, std::span<const double> xs, std::span<const double> ys, size_t budget)
+    {
+        const size_t n = xs.size();
+        Points &points = cache.points;
+        points.xs.clear();
+        points.ys.clear();
+        if (n <= budget) {
+            points.xs.assign(xs.begin(), xs.end());
+            points.ys.assign(ys.begin(), ys.end());
+            cache.picked.clear();
+            cache.width = 0;
+            return;
+        }
+
+        // the middle samples [1, n - 1) go into at most budget - 2 buckets
+        const size_t buckets = budget - 2;
+        bool restart = cache.width == 0 || n < cache.count || xs[0] != cache.first_x;
+        if (restart)
+            cache.width = std::max<size_t>(1, (n - 2 + buckets - 1) / buckets);
+        while ((n - 2 + cache.width - 1) / cache.width > buckets) {
+            cache.width *= 2;
+            restart = true;
+        }
+        if (restart)
+            cache.picked.clear();
+        cache.first_x = xs[0];
+
+        const size_t width = cache.width;
+        const size_t middle_end = n - 1;
+        auto bucketBegin = [&](size_t k) { return std::min(1 + k * width, middle_end); };
+        size_t bucket_count = (middle_end - 1 + width - 1) / width;
+        // complete buckets lie entirely before the last sample, which may still be revised
+        size_t complete = (middle_end - 1) / width;
+
+        // The point after bucket k: the mean of bucket k + 1, or the last sample past the end.
+        auto next = [&](size_t k, double &x, double &y) {
+            size_t begin = bucketBegin(k + 1), end = bucketBegin(k + 2);
+            if (begin == end) {
+                x = xs[n - 1];
+                y = ys[n - 1];
+                return;
+            }
+            x = y = 0.0;
+            for (size_t i = begin; i < end; ++i) {
+                x += xs[i];
+                y += ys[i];
+            }
+            x /= static_cast<double>(end - begin);
+            y /= static_cast<double>(end - begin);
+        };
+        auto pick = [&](size_t k, size_t previous) {
+            double cx, cy;
+            next(k, cx, cy);
+            double ax = xs[previous], ay = ys[previous];
+            size_t best = bucketBegin(k);
+            double best_area = -1.0;
+            for (size_t i = bucketBegin(k), end = bucketBegin(k + 1); i < end; ++i) {
+                // twice the triangle's area; the factor does not change the winner
+                double area = std::abs((ax - cx) * (ys[i] - ay) - (ax - xs[i]) * (cy - ay));
+                if (area > best_area) {
+                    best_area = area;
+                    best = i;
+                }
+            }
+            return best;
+        };
+
+        // a pick is final once the bucket after it is complete
+        size_t final_count = complete > 0 ? complete - 1 : 0;
+        for (size_t k = cache.picked.size(); k < final_count; ++k)
+            cache.picked.push_back(pick(k, k == 0 ? 0 : cache.picked.back()));
+
+        points.xs.reserve(bucket_count + 2);
+        points.ys.reserve(bucket_count + 2);
+        auto emit = [&](size_t i) {
+            points.xs.push_back(xs[i]);
+            points.ys.push_back(ys[i]);
+        };
+        emit(0);
+        for (size_t i : cache.picked)
+            emit(i);
+        size_t previous = cache.picked.empty() ? 0 : cache.picked.back();
+        for (size_t k = cache.picked.size(); k < bucket_count; ++k) {
+            previous = pick(k, previous);
+            emit(previous);
+        }
+        emit(n - 1);
+    }
+
+    std::vector<Cache> caches_;
+    uint64_t uses_ = 0;
+};
@@ -0,0 +1,251 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "candle_renderer.h"
+
+// Reduces a line of any number of samples to the points that rasterize the same at the current
+// zoom: for every pixel column the first and last sample in it plus its minimum and maximum
+// (M4, Jugel et al.). Everything a column contributes to the line is a vertical stroke between
+// its extremes and the joins to its neighbours, which these four points reproduce, so the plot
+// looks exactly like the full-resolution line while ImPlot tessellates at most four points per
+// pixel of plot width. One sample on either side of the visible range is kept so the line still
+// runs to the edges.
+//
+// The extremes of a column come from a two-level summary of block minima and maxima built once
+// per series version, so a column costs a few dozen comparisons however many samples it spans.
+// The result is cached until the series, the axis range or the plot width change.
+class M4Decimator
+{
+public:
+    static constexpr size_t kBlock = 64;
+    static constexpr size_t kGroup = 64 * kBlock;
+
+    struct Line
+    {
+        std::vector<double> xs;
+        std::vector<double> ys;
+
+        size_t size() const { return xs.size(); }
+    };
+
+    // The line through samples taken at a fixed rate, (x0 + i * dx, ys[i]), for an x axis spanning
+    // the pixels [pixel_lo, pixel_hi]. NaN samples (gaps) are never picked as extremes. The result
+    // stays valid until the next call.
+    const Line &decimateUniform(double x0, double dx, std::span<const double> ys, uint64_t version,
+                                AxisTransform x_axis, float pixel_lo, float pixel_hi)
+    {
+        Key key{ ys.data(), ys.size(), version, x0, dx, x_axis.min, x_axis.scale, x_axis.pixel_min,
+                 pixel_lo, pixel_hi };
+        return run(key, ys, x_axis, pixel_lo, pixel_hi, [&](size_t i) { return x0 + static_cast<double>(i) * dx; },
+                   [&](double x) {
+                       double i = std::ceil((x - x0) / dx);
+                       return i <= 0.0 ? size_t(0) : std::min(static_cast<size_t>(i), ys.size());
+                   });
+    }
+
+private:
+    struct Key
+    {
+        const double *ys = nullptr;
+        size_t count = 0;
+        uint64_t version = 0;
+        double x0 = 0.0;
+        double dx = 0.0;
+        double axis_min = 0.0;
+        double axis_scale = 0.0;
+        double axis_pixel_min = 0.0;
+        float pixel_lo = 0.0f;
+        float pixel_hi = 0.0f;
+
+        bool operator==(const Key &) const = default;
+    };
+
+    // Index of the minimum and of the maximum of a sample range; ties go to the earlier sample.
+    struct Extremes
+    {
+        size_t min;
+        size_t max;
+    };
+
+    // x_of(i) is the x of sample i, lowerBound(x) the first sample at or after x.
+    template<typename XOf, typename LowerBound>
+    const Line &run(const Key &key, std::span<const double> ys, AxisTransform x_axis, float pixel_lo,
+                    float pixel_hi, XOf x_of, LowerBound lowerBound)
+    {
+        if (key == key_)
+            return line_;
+        key_ = key;
+        if (ys.data() != summary_ys_ || ys.size() != summary_count_ || key.version != summary_version_)
+            summarize(ys, key.version);
+
+        line_.xs.clear();
+        line_.ys.clear();
+        size_t last_emitted = std::numeric_limits<size_t>::max();
+        auto emit = [&](size_t i) {
+            if (i == last_emitted)
+                return;
+            line_.xs.push_back(x_of(i));
+            line_.ys.push_back(ys[i]);
+            last_emitted = i;
+        };
+        if (ys.empty() || !(x_axis.scale != 0.0))
+            return line_;
+
+        // columns are laid out on whole pixels, in x order even on an inverted axis
+        double first_pixel = std::floor(std::min(pixel_lo, pixel_hi));
+        int columns = std::max(1, static_cast<int>(std::ceil(std::max(pixel_lo, pixel_hi)) - first_pixel));
+        double left = x_axis.toPlot(first_pixel), right = x_axis.toPlot(first_pixel + columns);
+        if (left > right)
+            std::swap(left, right);
+        double width = (right - left) / columns;
+
+        size_t begin = lowerBound(left);
+        if (begin > 0)
+            emit(begin - 1);
+        for (int c = 0; c < columns; ++c) {
+            size_t end = c + 1 < columns ? lowerBound(left + (c + 1) * width)
+                                         : lowerBound(std::nextafter(right, std::numeric_limits<double>::infinity()));
+            if (begin >= end)
+                continue;
+            emit(begin);
+            // a column of nothing but NaN is just its ends
+            if (auto extremes = find(ys.data(), begin, end)) {
+                emit(std::min(extremes->min, extremes->max));
+                emit(std::max(extremes->min, extremes->max));
+            }
+            emit(end - 1);
+            begin = end;
+        }
+        if (begin < ys.size())
+            emit(begin);
+        return line_;
+    }
+
+    void summarize(std::span<const double> ys, uint64_t version)
+    {
+        summary_ys_ = ys.data();
+        summary_count_ = ys.size();
+        summary_version_ = version;
+        size_t blocks = ys.size() / kBlock;
+        block_min_.resize(blocks);
+        block_max_.resize(blocks);
+        for (size_t b = 0; b < blocks; ++b)
+            blockMinMax(ys.data() + b * kBlock, block_min_[b], block_max_[b]);
+        size_t groups = ys.size() / kGroup;
+        group_min_.resize(groups);
+        group_max_.resize(groups);
+        for (size_t g = 0; g < groups; ++g) {
+            group_min_[g] = *std::min_element(block_min_.begin() + g * (kGroup / kBlock),
+                                              block_min_.begin() + (g + 1) * (kGroup / kBlock));
+            group_max_[g] = *std::max_element(block_max_.begin() + g * (kGroup / kBlock),
+                                              block_max_.begin() + (g + 1) * (kGroup / kBlock));
+        }
+    }
+
+    // NaN samples are skipped; a block of nothing but NaN gets min = inf and max = -inf.
+    static void blockMinMax(const double *values, double &min, double &max)
+    {
+#if defined(__SSE2__)
+        // minpd and maxpd return their second operand when either is NaN
+        __m128d lo0 = _mm_set1_pd(std::numeric_limits<double>::infinity()), lo1 = lo0;
+        __m128d hi0 = _mm_set1_pd(-std::numeric_limits<double>::infinity()), hi1 = hi0;
+        for (size_t i = 0; i < kBlock; i += 4) {
+            __m128d a = _mm_loadu_pd(values + i), b = _mm_loadu_pd(values + i + 2);
+            lo0 = _mm_min_pd(a, lo0);
+            lo1 = _mm_min_pd(b, lo1);
+            hi0 = _mm_max_pd(a, hi0);
+            hi1 = _mm_max_pd(b, hi1);
+        }
+        alignas(16) double lo[2], hi[2];
+        _mm_store_pd(lo, _mm_min_pd(lo0, lo1));
+        _mm_store_pd(hi, _mm_max_pd(hi0, hi1));
+        min = std::min(lo[0], lo[1]);
+        max = std::max(hi[0], hi[1]);
+#else
+        min = std::numeric_limits<double>::infinity();
+        max = -std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < kBlock; ++i) {
+            min = values[i] < min ? values[i] : min;
+            max = values[i] > max ? values[i] : max;
+        }
+#endif
+    }
+
+    // Walks [begin, end) as loose samples up to a block boundary, whole blocks up to a group
+    // boundary, whole groups, then blocks and samples again, remembering which piece holds each
+    // extreme; only that piece is then searched for the sample itself. NaN compares false and
+    // drops out, so a range of nothing but NaN has no extremes.
+    std::optional<Extremes> find(const double *ys, size_t begin, size_t end) const
+    {
+        struct Piece
+        {
+            double value;
+            size_t begin;
+            size_t size;
+        };
+        Piece lo{ std::numeric_limits<double>::infinity(), begin, 0 };
+        Piece hi{ -std::numeric_limits<double>::infinity(), begin, 0 };
+        auto add = [&](double min, double max, size_t at, size_t size) {
+            if (min < lo.value)
+                lo = { min, at, size };
+            if (max > hi.value)
+                hi = { max, at, size };
+        };
+
+        size_t i = begin;
+        for (; i < end && i % kBlock != 0; ++i)
+            add(ys[i], ys[i], i, 1);
+        for (; i + kBlock <= end && i % kGroup != 0; i += kBlock)
+            add(block_min_[i / kBlock], block_max_[i / kBlock], i, kBlock);
+        for (; i + kGroup <= end; i += kGroup)
+            add(group_min_[i / kGroup], group_max_[i / kGroup], i, kGroup);
+        for (; i + kBlock <= end; i += kBlock)
+            add(block_min_[i / kBlock], block_max_[i / kBlock], i, kBlock);
+        for (; i < end; ++i)
+            add(ys[i], ys[i], i, 1);
+
+        if (lo.size == 0 || hi.size == 0)
+            return std::nullopt;
+        return Extremes{ .min = locate(ys, lo, block_min_), .max = locate(ys, hi, block_max_) };
+    }
+
+    // First sample of the piece equal to its extreme, narrowing a group down to its block first.
+    template<typename Piece>
+    static size_t locate(const double *ys, const Piece &piece, const std::vector<double> &blocks)
+    {
+        size_t begin = piece.begin, size = piece.size;
+        if (size == kGroup) {
+            size_t b = begin / kBlock;
+            while (blocks[b] != piece.value)
+                ++b;
+            begin = b * kBlock;
+            size = kBlock;
+        }
+        size_t found = static_cast<size_t>(std::find(ys + begin, ys + begin + size, piece.value) - ys);
+        return std::min(found, begin + size - 1);
+    }
+
+    Key key_;
+    Line line_;
+
+    const double *summary_ys_ = nullptr;
+    size_t summary_count_ = 0;
+    uint64_t summary_version_ = 0;
+    std::vector<double> block_min_, block_max_;
+    std::vector<double> group_min_, group_max_;
+};
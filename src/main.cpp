@@ -2,140 +2,327 @@
 // SPDX-License-Identifier: MIT
 
 #include "scene.h"
+#include "gl_state.h"
+#include "scene_texture.h"
+#include "gl_worker.h"
+#include "damage_tracker.h"
+#include "candle_renderer.h"
+#include "ohlc_pyramid.h"
+#include "nearest_index.h"
+#include "ohlc_series.h"
+#include "ohlc_file.h"
+#include "csv_importer.h"
+#include "tick_feed.h"
+#include "range_extrema.h"
+#include "indicators.h"
+#include "m4_decimator.h"
+#include "lttb.h"
+#include "ring_series.h"
+#include "scrolling_heatmap.h"
+#include "scene_invalidation.h"
 
 #include <cstdlib>
 #include <print>
 #include <stdlib.h>
 #include <cassert>
 #include <concepts>
+#include <chrono>
+#include <optional>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+#include <filesystem>
 
 #include <GLES3/gl3.h>
 #include <GLES3/gl3platform.h>
 
 #include "imgui.h"
+#include "imgui_internal.h"
 #include "imgui_impl_opengl3.h"
 #include "implot.h"
 #include "implot_internal.h"
 
 using std::println;
 
-#define DEFINE_SCOPED_BINDING(StructName, ParamName, BindingFn, TargetName)                        \
-    struct StructName                                                                              \
-    {                                                                                              \
-        GLuint saved_value = {};                                                                   \
-        StructName() = delete;                                                                     \
-        StructName(const StructName &) = delete;                                                   \
-        StructName &operator=(const StructName &) = delete;                                        \
-        StructName(GLuint new_value)                                                               \
-        {                                                                                          \
-            glGetIntegerv(ParamName, (GLint *)&saved_value);                                       \
-            BindingFn(TargetName, new_value);                                                      \
-        }                                                                                          \
-        ~StructName()                                                                              \
-        {                                                                                          \
-            BindingFn(TargetName, saved_value);                                                    \
-        }                                                                                          \
-    }
-
-DEFINE_SCOPED_BINDING(ScopedTextureBinding, GL_TEXTURE_BINDING_2D, glBindTexture, GL_TEXTURE_2D);
-DEFINE_SCOPED_BINDING(ScopedFrameBufferBinding, GL_DRAW_FRAMEBUFFER_BINDING, glBindFramebuffer,
-                      GL_DRAW_FRAMEBUFFER);
-
-struct SceneTexture
+// Steady-clock source for io.DeltaTime.
+// A frame that follows an idle period gets a nominal delta, so ImGui timers (hover delays,
+// double-click detection) don't jump by however long the scene was sitting idle.
+class FrameClock
 {
-    GLuint texture;
-    int width;
-    int height;
-    GLuint fbo;
+public:
+    using clock = std::chrono::steady_clock;
 
-    SceneTexture(int width, int height) : width(width), height(height)
+    float tick()
     {
-        glGenFramebuffers(1, &fbo);
-        glGenTextures(1, &texture);
+        auto now = clock::now();
+        float delta = idle_ ? kNominalDelta : std::chrono::duration<float>(now - last_).count();
+        last_ = now;
+        idle_ = false;
+        return std::clamp(delta, kMinDelta, kMaxDelta);
+    }
+
+    void markIdle() { idle_ = true; }
+
+private:
+    static constexpr float kNominalDelta = 1.0f / 60.0f;
+    static constexpr float kMinDelta = 1.0f / 1000.0f;
+    static constexpr float kMaxDelta = 1.0f;
 
-        ScopedTextureBinding activeTexture(texture);
+    clock::time_point last_ = clock::now();
+    bool idle_ = true;
+};
 
-        GLint old_unpack_alignment;
-        glGetIntegerv(GL_UNPACK_ALIGNMENT, &old_unpack_alignment);
-        GLint old_unpack_row_length;
-        glGetIntegerv(GL_UNPACK_ROW_LENGTH, &old_unpack_row_length);
-        GLint old_unpack_skip_pixels;
-        glGetIntegerv(GL_UNPACK_SKIP_PIXELS, &old_unpack_skip_pixels);
-        GLint old_unpack_skip_rows;
-        glGetIntegerv(GL_UNPACK_SKIP_ROWS, &old_unpack_skip_rows);
+// Picks the fraction of full resolution to render at while the user drags or scrolls. Frames
+// whose work (building and drawing, not the wait for vsync) takes longer than the budget step the
+// resolution down, frames with plenty of headroom step it back up, and full resolution returns as
+// soon as the interaction ends.
+class ResolutionScaler
+{
+public:
+    static constexpr std::array<float, 4> kSteps = { 1.0f, 0.75f, 0.5f, 0.35f };
+
+    explicit ResolutionScaler(std::chrono::microseconds budget)
+        : budget_(std::chrono::duration<float>(budget).count())
+    {
+    }
 
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
-        glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
-        glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    float update(bool interacting, float frame_cost)
+    {
+        if (!interacting) {
+            step_ = 0;
+            average_ = 0.0f;
+            return 1.0f;
+        }
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                     nullptr);
+        average_ = average_ == 0.0f ? frame_cost : std::lerp(average_, frame_cost, 0.25f);
+        // After a step the average restarts at the budget, so the next step needs fresh evidence.
+        if (average_ > budget_ && step_ + 1 < kSteps.size()) {
+            ++step_;
+            average_ = budget_;
+        } else if (average_ < budget_ * 0.5f && step_ > 0) {
+            --step_;
+            average_ = budget_;
+        }
+        return kSteps[step_];
+    }
 
-        ScopedFrameBufferBinding activeFBO(fbo);
+    bool reduced() const { return step_ > 0; }
 
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+private:
+    float budget_;
+    float average_ = 0.0f;
+    size_t step_ = 0;
+};
 
-        assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+// Holds back rendering while the requested texture size keeps changing, so a window drag does
+// not re-layout and re-render the scene for every intermediate size. Meanwhile Slint keeps
+// stretching the last texture over the component. A new size is rendered once it has been stable
+// for the debounce window, or when the last render is max_interval old, whichever comes first.
+class ResizeDebouncer
+{
+public:
+    using clock = std::chrono::steady_clock;
 
-        glPixelStorei(GL_UNPACK_ALIGNMENT, old_unpack_alignment);
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, old_unpack_row_length);
-        glPixelStorei(GL_UNPACK_SKIP_PIXELS, old_unpack_skip_pixels);
-        glPixelStorei(GL_UNPACK_SKIP_ROWS, old_unpack_skip_rows);
+    ResizeDebouncer(std::chrono::milliseconds debounce, std::chrono::milliseconds max_interval)
+        : debounce_(debounce), max_interval_(max_interval)
+    {
     }
-    SceneTexture(const SceneTexture &) = delete;
-    SceneTexture &operator=(const SceneTexture &) = delete;
-    ~SceneTexture()
+
+    // Returns how long to hold back a frame at width x height, or std::nullopt to render it now.
+    std::optional<std::chrono::milliseconds> defer(int width, int height)
     {
-        glDeleteFramebuffers(1, &fbo);
-        glDeleteTextures(1, &texture);
+        using namespace std::chrono;
+        auto now = clock::now();
+        if (width != pending_width_ || height != pending_height_) {
+            pending_width_ = width;
+            pending_height_ = height;
+            changed_ = now;
+        }
+
+        if ((width == rendered_width_ && height == rendered_height_) || debounce_.count() == 0)
+            return std::nullopt;
+
+        auto wait = std::min(changed_ + debounce_, rendered_ + max_interval_) - now;
+        if (wait <= clock::duration::zero())
+            return std::nullopt;
+        return std::chrono::ceil<milliseconds>(wait);
     }
 
-    template<std::invocable<> Callback>
-    void with_active_fbo(Callback callback)
+    void rendered(int width, int height)
     {
-        ScopedFrameBufferBinding activeFBO(fbo);
-        callback();
+        rendered_width_ = width;
+        rendered_height_ = height;
+        rendered_ = clock::now();
     }
+
+private:
+    std::chrono::milliseconds debounce_;
+    std::chrono::milliseconds max_interval_;
+    int pending_width_ = -1;
+    int pending_height_ = -1;
+    clock::time_point changed_;
+    int rendered_width_ = -1;
+    int rendered_height_ = -1;
+    clock::time_point rendered_;
 };
 
+// Opt-in renderer diagnostics: with SLINT_IMGUI_STATS set in the environment, a summary of the
+// last second's ImGui frames is printed to stderr.
+class RenderStats
+{
+public:
+    RenderStats() : enabled_(std::getenv("SLINT_IMGUI_STATS") != nullptr) { }
+
+    void frameRendered(float damage_coverage, int damage_rects)
+    {
+        ++rendered_;
+        damage_coverage_ += damage_coverage;
+        damage_rects_ += damage_rects;
+    }
+    void frameSkipped() { ++skipped_; }
+    void stalled(std::chrono::nanoseconds time) { stall_time_ += time; }
+
+    void record(const GLStateCache::Stats &gl)
+    {
+        gl_ += gl;
+        if (!enabled_)
+            return;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_report_ < std::chrono::seconds(1))
+            return;
+
+        int frames = std::max(1, rendered_ + skipped_);
+        int rendered = std::max(1, rendered_);
+        println(stderr,
+                "imgui: {} frames rendered, {} unchanged, {:.2f} ms waiting on texture fences, "
+                "{:.0f}% of pixels redrawn in {:.1f} damage rects per rendered frame | "
+                "per frame: {:.1f} glGet issued outside the ImGui backend, {:.1f} served from shadow, "
+                "{:.1f} redundant binds skipped",
+                rendered_, skipped_,
+                std::chrono::duration<double, std::milli>(stall_time_).count(),
+                100.0f * damage_coverage_ / rendered, float(damage_rects_) / rendered,
+                float(gl_.queries) / frames, float(gl_.cached_reads) / frames,
+                float(gl_.skipped_writes) / frames);
+
+        last_report_ = now;
+        rendered_ = 0;
+        skipped_ = 0;
+        damage_coverage_ = 0.0f;
+        damage_rects_ = 0;
+        stall_time_ = {};
+        gl_ = {};
+    }
+
+private:
+    bool enabled_;
+    std::chrono::steady_clock::time_point last_report_ = std::chrono::steady_clock::now();
+    int rendered_ = 0;
+    int skipped_ = 0;
+    float damage_coverage_ = 0.0f;
+    int damage_rects_ = 0;
+    std::chrono::nanoseconds stall_time_{};
+    GLStateCache::Stats gl_;
+};
 
+// A scene announces changes to what it is built from through its invalidation(): bind() connects
+// the Slint change callbacks of the properties it reads, its data sources invalidate as they
+// deliver. needsUpdate() is called only once the generation moved, to pick up the changes and say
+// whether they need a new frame.
 template<typename Scene>
 concept ImGuiSceneBuilder = requires(Scene &scene, slint::ComponentHandle<App> &app) {
     { scene.setup() } -> std::same_as<void>;
     { scene.teardown() } -> std::same_as<void>;
+    { scene.bind(app) } -> std::same_as<void>;
+    { scene.invalidation() } -> std::same_as<SceneInvalidation &>;
     { scene.needsUpdate(app) } -> std::convertible_to<bool>;
     { scene.build(app) } -> std::same_as<void>;
     requires std::is_default_constructible_v<Scene>;
 };
 
+// Scenes whose build() only reads state captured in needsUpdate() and never touches the Slint
+// component it is handed can be built off the UI thread.
+template<typename Scene>
+concept ThreadSafeImGuiSceneBuilder = ImGuiSceneBuilder<Scene> && requires {
+    requires Scene::kThreadSafeBuild;
+};
+
+struct ImGuiRendererOptions
+{
+    // Build and draw the scene on a GL worker thread with a shared context, so a slow frame
+    // doesn't hold up Slint. Takes effect only for thread-safe scenes on an EGL-based Slint
+    // renderer; rendering stays on the UI thread otherwise.
+    bool render_on_worker_thread = false;
+
+    // Render at reduced resolution (and let Slint upscale) while a drag or wheel gesture is in
+    // progress and building and drawing a frame takes longer than frame_budget (measured on the
+    // CPU, as the GL calls are issued); full resolution returns once input goes idle.
+    bool adaptive_resolution = false;
+    std::chrono::microseconds frame_budget{ 16'667 };
+
+    // While the window is being resized the previous frame is shown stretched, and the scene is
+    // re-rendered only once the size has been stable for resize_debounce, or at most every
+    // resize_max_interval. A zero resize_debounce renders every intermediate size.
+    std::chrono::milliseconds resize_debounce{ 80 };
+    std::chrono::milliseconds resize_max_interval{ 250 };
+
+    // Draws ImGui straight into Slint's framebuffer after Slint has rendered the window, clipped
+    // to the ImGui component, instead of going through a scene texture that Slint samples again.
+    // Every Slint frame then redraws the scene, so render_on_worker_thread, adaptive_resolution
+    // and resize debouncing do not apply.
+    bool draw_to_window = false;
+};
+
 template<ImGuiSceneBuilder Scene>
 class ImGuiRenderer
 {
 public:
-    ImGuiRenderer(slint::ComponentWeakHandle<App> app) : app_weak_(app) { }
+    ImGuiRenderer(slint::ComponentWeakHandle<App> app, ImGuiRendererOptions options = {})
+        : app_weak_(app), options_(options)
+    {
+    }
 
     void operator()(slint::RenderingState state, slint::GraphicsAPI)
     {
+        // Slint has had the context to itself since the previous callback.
+        glStateCache().invalidate();
+
         switch (state) {
         case slint::RenderingState::RenderingSetup:
             if (auto app = app_weak_.lock()) {
                 setup(*app);
-                updateTexture(*app);
+                update(*app);
                 (*app)->window().request_redraw();
             }
             break;
         case slint::RenderingState::BeforeRendering:
-            if (auto app = app_weak_.lock()) {
-                if (input_pending_ || scene_.needsUpdate(*app))
-                    updateTexture(*app);
-            }
+            if (auto app = app_weak_.lock())
+                update(*app);
+            stats_.record(glStateCache().takeStats());
             break;
         case slint::RenderingState::AfterRendering:
+            if (options_.draw_to_window) {
+                if (auto app = app_weak_.lock())
+                    drawToWindow(*app);
+            }
+            // Slint has now issued everything that samples the displayed texture this frame.
+            texture_ring_.fenceDisplayed();
+            // Redraw requests issued while Slint is still rendering may get folded into the
+            // current frame, so the follow-up frame is requested only once it is done. A busy
+            // worker requests its own redraw when it finishes.
+            if (frame_pending_ && !worker_busy_)
+                requestRedraw();
             break;
         case slint::RenderingState::RenderingTeardown:
             teardown();
@@ -144,6 +331,32 @@ public:
     }
 
 private:
+    // Everything the render side needs to produce one frame.
+    struct FrameRequest
+    {
+        int width;  // physical pixels
+        int height; // physical pixels
+        float scale_factor;
+        bool resize_settled;
+    };
+
+    struct RenderedFrame
+    {
+        SceneTexture *target;
+        TextureClip clip;
+        GLsync ready_fence; // set when rendered on the worker
+        float damage_coverage;
+        int damage_rects;   // zero for a full redraw
+    };
+
+    // State handed between the UI thread and the render side (the GL worker, if there is one).
+    struct Mailbox
+    {
+        std::mutex mutex;
+        std::vector<std::function<void(ImGuiIO &)>> input;
+        bool frame_done = false;
+        std::optional<RenderedFrame> frame;
+    };
 
     ImGuiMouseButton_ toImGuiMouseButton(slint::cbindgen_private::PointerEventButton button)
     {
@@ -162,6 +375,63 @@ private:
     }
 
     void setup(slint::ComponentHandle<App> &app)
+    {
+        if (options_.render_on_worker_thread && !options_.draw_to_window) {
+            if constexpr (ThreadSafeImGuiSceneBuilder<Scene>)
+                worker_ = GLWorker::create();
+            if (!worker_)
+                println(stderr, "ImGui worker thread unavailable, rendering on the UI thread");
+        }
+        render_on_worker_ = worker_ != nullptr;
+
+        if (worker_)
+            worker_->post([this]() { setupImGui(); });
+        else
+            setupImGui();
+
+        wake_timer_ = std::make_unique<slint::Timer>();
+        resize_settle_timer_ = std::make_unique<slint::Timer>();
+        frame_pending_ = true;
+
+        // Invalidations may come from any thread, so the redraw is requested from the event loop.
+        scene_.invalidation().wakeWith([app_weak = app_weak_]() {
+            slint::invoke_from_event_loop([app_weak]() {
+                if (auto app = app_weak.lock())
+                    (*app)->window().request_redraw();
+            });
+        });
+        scene_.bind(app);
+        // the scene has not seen any of its inputs yet
+        scene_.invalidation().invalidate();
+
+        using namespace slint::cbindgen_private;
+
+        app->global<ImGuiAdapter>().on_forward_pointer_event([this](const PointerEvent &event, float x, float y) {
+            bool changes_button = event.kind == PointerEventKind::Down || event.kind == PointerEventKind::Up;
+            auto button = changes_button ? toImGuiMouseButton(event.button) : ImGuiMouseButton_Left;
+            bool pressed = event.kind == PointerEventKind::Down;
+            queueInput([=](ImGuiIO &io) {
+                io.AddMouseSourceEvent(ImGuiMouseSource_Mouse);
+                io.AddMousePosEvent(x, y);
+
+                if (changes_button)
+                    io.AddMouseButtonEvent(button, pressed);
+            });
+        });
+
+        app->global<ImGuiAdapter>().on_forward_scroll_event([this](const PointerScrollEvent &event) {
+            float wheel_x = event.modifiers.shift ? event.delta_y : event.delta_x;
+            float wheel_y = event.modifiers.shift ? event.delta_x : event.delta_y;
+            queueInput([=](ImGuiIO &io) {
+                io.AddMouseSourceEvent(ImGuiMouseSource_Mouse);
+                io.AddMouseWheelEvent(wheel_x, wheel_y);
+            });
+            return EventResult::Accept;
+        });
+    }
+
+    // Runs on the render side.
+    void setupImGui()
     {
         IMGUI_CHECKVERSION();
         ctx_ = ImGui::CreateContext();
@@ -173,117 +443,544 @@ private:
 
         ImGui_ImplOpenGL3_Init("#version 300 es");
 
-        displayed_texture_ = std::make_unique<SceneTexture>(320, 200);
-        next_texture_ = std::make_unique<SceneTexture>(320, 200);
+        scene_.setup();
+    }
 
-        using namespace slint::cbindgen_private;
+    // Input reaches the ImGui context at the start of the next frame, on whichever thread
+    // renders it.
+    void queueInput(std::function<void(ImGuiIO &)> event)
+    {
+        {
+            std::lock_guard lock(mailbox_->mutex);
+            mailbox_->input.push_back(std::move(event));
+        }
+        updateInputPending();
+    }
 
-        app->global<ImGuiAdapter>().on_forward_pointer_event([this](const PointerEvent &event, float x, float y) {
-            auto &io = ImGui::GetIO(ctx_);
-            io.AddMouseSourceEvent(ImGuiMouseSource_Mouse);
-            io.AddMousePosEvent(x, y);
+    void updateInputPending()
+    {
+        input_pending_ = true;
+        settle_frames_ = kSettleFrames;
+        requestRedraw();
+    }
 
-            if (event.kind == PointerEventKind::Down || event.kind == PointerEventKind::Up)
-                io.AddMouseButtonEvent(toImGuiMouseButton(event.button), event.kind == PointerEventKind::Down);
+    void requestRedraw()
+    {
+        if (auto a = app_weak_.lock())
+            (*a)->window().request_redraw();
+    }
 
-            updateInputPending();
-        });
+    void update(slint::ComponentHandle<App> &app)
+    {
+        // While the worker is busy the scene and the ImGui context belong to it.
+        if (worker_busy_ && !collectWorkerFrame(app))
+            return;
+
+        // Input does not tell the scene what changed, so a change is picked up even when a frame
+        // is due anyway.
+        uint64_t generation = scene_.invalidation().generation();
+        bool changed = std::exchange(built_generation_, generation) != generation && scene_.needsUpdate(app);
+        if (!input_pending_ && !frame_pending_ && !frame_held_ && !changed)
+            return;
+
+        // needsUpdate() may have consumed the change already, so a held back frame stays due. It
+        // is not pending though: only the wake timer brings it back, while Slint keeps stretching
+        // the last texture without redrawing after every frame. Nothing is left to stretch when
+        // drawing to the window, so every size is rendered.
+        auto hold = options_.draw_to_window ? std::nullopt : resize_debouncer_.defer(app->get_requested_texture_width(),
+                                            app->get_requested_texture_height());
+        if (hold) {
+            frame_pending_ = false;
+            frame_held_ = true;
+            wake_timer_->start(slint::TimerMode::SingleShot, *hold, [this]() { requestRedraw(); });
+            return;
+        }
 
-        app->global<ImGuiAdapter>().on_forward_scroll_event([this](const PointerScrollEvent &event) {
-            auto &io = ImGui::GetIO(ctx_);
-            io.AddMouseSourceEvent(ImGuiMouseSource_Mouse);
-            if (!event.modifiers.shift)
-                io.AddMouseWheelEvent(event.delta_x, event.delta_y);
-            else
-                io.AddMouseWheelEvent(event.delta_y, event.delta_x);
+        startFrame(app);
+    }
 
-            updateInputPending();
-            return EventResult::Accept;
+    void startFrame(slint::ComponentHandle<App> &app)
+    {
+        input_pending_ = false;
+        frame_pending_ = false;
+        frame_held_ = false;
+        wake_timer_->stop();
+
+        FrameRequest request{ .width = app->get_requested_texture_width(),
+                              .height = app->get_requested_texture_height(),
+                              .scale_factor = app->window().scale_factor(),
+                              .resize_settled = std::exchange(resize_settled_, false) };
+
+        resize_debouncer_.rendered(request.width, request.height);
+        if (request.width != texture_width_ || request.height != texture_height_) {
+            texture_width_ = request.width;
+            texture_height_ = request.height;
+            resize_settle_timer_->start(slint::TimerMode::SingleShot, kResizeSettleDelay,
+                                        [this]() { onResizeSettled(); });
+        }
+
+        if (options_.draw_to_window) {
+            auto *saved_ctx = ImGui::GetCurrentContext();
+            ImGui::SetCurrentContext(ctx_);
+            buildFrame(app, request);
+            ImGui::SetCurrentContext(saved_ctx);
+            // Drawn by drawToWindow() once Slint is done with this frame.
+            window_frame_ = true;
+            stats_.frameRendered(1.0f, 0);
+            scheduleNextFrame();
+            return;
+        }
+
+        if (!worker_) {
+            finishFrame(app, render(app, request));
+            return;
+        }
+
+        // The worker only ever gets a reference; the handle is created and released here.
+        worker_busy_ = true;
+        worker_app_ = app;
+        worker_->post([this, request]() {
+            auto frame = render(*worker_app_, request);
+            {
+                std::lock_guard lock(mailbox_->mutex);
+                mailbox_->frame_done = true;
+                mailbox_->frame = frame;
+            }
+            slint::invoke_from_event_loop([this]() { requestRedraw(); });
         });
+    }
 
-        scene_.setup();
+    // Returns false while the worker is still rendering.
+    bool collectWorkerFrame(slint::ComponentHandle<App> &app)
+    {
+        std::optional<RenderedFrame> frame;
+        {
+            std::lock_guard lock(mailbox_->mutex);
+            if (!mailbox_->frame_done)
+                return false;
+            mailbox_->frame_done = false;
+            frame = std::exchange(mailbox_->frame, std::nullopt);
+        }
+        worker_busy_ = false;
+        worker_app_.reset();
+        finishFrame(app, frame);
+        return true;
     }
 
-    void updateInputPending()
+    void finishFrame(slint::ComponentHandle<App> &app, const std::optional<RenderedFrame> &frame)
     {
-        input_pending_ = true;
-        if (auto a = app_weak_.lock())
-            (*a)->window().request_redraw();
+        if (frame) {
+            // Keeps Slint's context from sampling the texture before the worker's draw landed.
+            if (frame->ready_fence) {
+                glWaitSync(frame->ready_fence, 0, GL_TIMEOUT_IGNORED);
+                glDeleteSync(frame->ready_fence);
+            }
+            app->set_texture(slint::Image::create_from_borrowed_gl_2d_rgba_texture(
+                    frame->target->texture,
+                    { static_cast<uint32_t>(frame->target->width),
+                      static_cast<uint32_t>(frame->target->height) },
+                    slint::Image::BorrowedOpenGLTextureOrigin::BottomLeft));
+            app->set_texture_clip(frame->clip);
+            texture_ring_.present();
+            stats_.frameRendered(frame->damage_coverage, frame->damage_rects);
+        } else {
+            stats_.frameSkipped();
+        }
+        stats_.stalled(texture_ring_.takeStallTime());
+        scheduleNextFrame();
     }
 
-    void updateTexture(slint::ComponentHandle<App> &app)
+    // Decides when ImGui needs to see another frame without any new input:
+    // std::nullopt when it is idle, zero for the very next frame, otherwise the delay
+    // until something visible changes (cursor blink, tooltip delay).
+    std::optional<std::chrono::milliseconds> nextFrameDelay() const
     {
-        app->set_texture(render(app));
+        using namespace std::chrono;
+        const ImGuiContext &g = *ctx_;
+
+        // Events trickled over to the next frame, widgets being held (repeat buttons,
+        // drag-select), nav windowing and modal dimming all advance every frame. A text field
+        // stays active for as long as it is edited; its caret blink is scheduled below.
+        bool active = g.ActiveId != 0 && g.ActiveId != g.InputTextState.ID;
+        if (!g.InputEventsQueue.empty() || active || g.NavWindowingTarget != nullptr
+            || g.DragDropActive || (g.DimBgRatio > 0.0f && g.DimBgRatio < 1.0f))
+            return milliseconds(0);
+
+        // Layout and hover state settle a couple of frames after the input that changed them,
+        // and shrinking the texture ring after a resize takes one frame per slot. Gestures keep
+        // frames coming so the resolution scaler can measure them, and a reduced-resolution
+        // frame is always followed up at full resolution.
+        if (settle_frames_ > 0 || shrink_frames_ > 0 || interacting_ || resolution_scaler_.reduced())
+            return milliseconds(0);
+
+        float wait = INFINITY;
+        if (g.IO.WantTextInput && g.IO.ConfigInputTextCursorBlink && g.InputTextState.ID != 0) {
+            // Mirrors InputTextEx: caret is visible while anim <= 0 or fmod(anim, 1.2) <= 0.8.
+            float anim = g.InputTextState.CursorAnim;
+            float phase = std::fmod(anim, 1.20f);
+            wait = anim <= 0.0f ? 0.80f - anim : phase <= 0.80f ? 0.80f - phase : 1.20f - phase;
+        }
+        if (g.HoverItemDelayId != 0) {
+            for (float delay : { g.Style.HoverDelayShort, g.Style.HoverDelayNormal })
+                if (g.HoverItemDelayTimer < delay)
+                    wait = std::min(wait, delay - g.HoverItemDelayTimer);
+        }
+
+        if (wait == INFINITY)
+            return std::nullopt;
+        return std::chrono::ceil<milliseconds>(duration<float>(wait));
     }
 
-    slint::Image render(slint::ComponentHandle<App> &app)
+    void scheduleNextFrame()
     {
-        input_pending_ = false;
-        auto width = app->get_requested_texture_width();
-        auto height = app->get_requested_texture_height();
+        auto delay = nextFrameDelay();
+        if (settle_frames_ > 0)
+            --settle_frames_;
+
+        if (!delay) {
+            clock_.markIdle();
+        } else if (delay->count() == 0) {
+            frame_pending_ = true;
+        } else {
+            wake_timer_->start(slint::TimerMode::SingleShot, *delay, [this]() {
+                frame_pending_ = true;
+                requestRedraw();
+            });
+        }
+    }
 
-        if (next_texture_->width != width || next_texture_->height != height) {
-            auto new_texture = std::make_unique<SceneTexture>(width, height);
-            std::swap(next_texture_, new_texture);
+    // Runs on the render side. Returns std::nullopt when the frame came out identical to the
+    // one already displayed, in which case nothing was drawn and the current texture stays.
+    std::optional<RenderedFrame> render(slint::ComponentHandle<App> &app, const FrameRequest &request)
+    {
+        auto *saved_ctx = ImGui::GetCurrentContext();
+        ImGui::SetCurrentContext(ctx_);
+        auto work_start = std::chrono::steady_clock::now();
+
+        ImDrawData *draw_data = buildFrame(app, request);
+
+        // The resolution scale is applied to the draw data only, after ImGui has laid out the
+        // frame, so fonts keep being rasterized for the real display density. It has to be picked
+        // before drawing, so it goes by what the previous frame cost.
+        if (options_.adaptive_resolution) {
+            float scale = resolution_scaler_.update(isInteracting(), frame_cost_);
+            draw_data->FramebufferScale.x *= scale;
+            draw_data->FramebufferScale.y *= scale;
+        }
+        // Computed exactly like the backend sizes its viewport.
+        int width = static_cast<int>(draw_data->DisplaySize.x * draw_data->FramebufferScale.x);
+        int height = static_cast<int>(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
+
+        // Once the size has been stable for a while, textures grown during the resize are
+        // swapped for right-sized ones over the next frames and the pool is trimmed to budget.
+        if (request.resize_settled) {
+            if (texture_ring_.hasOversized(request.width, request.height))
+                shrink_frames_ = SceneTextureRing::kSize;
+            else
+                texture_ring_.trim();
         }
 
-        next_texture_->with_active_fbo([&]() {
-            GLint saved_viewport[4];
-            glGetIntegerv(GL_VIEWPORT, saved_viewport);
+        // Partial redraws build on the previous output, copied forward from what is displayed.
+        SceneTexture *previous = texture_ring_.displayed();
+        auto damage = damage_tracker_.update(*draw_data);
+        if (hasPendingTextureUpdates(*draw_data) || previous == nullptr) {
+            damage.full = true;
+            damage.rects.clear();
+        }
 
-            glViewport(0, 0, next_texture_->width, next_texture_->height);
-            glClearColor(0.1f, 0.1f, 0.12f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT);
+        std::optional<RenderedFrame> frame;
+        if (!damage.empty() || shrink_frames_ > 0) {
+            SceneTexture &target = acquireTarget(width, height);
+
+            target.with_active_fbo([&]() {
+                auto &gl = glStateCache();
+                bool saved_scissor_test = gl.scissorTest();
+                GLStateCache::Box saved_scissor_box = gl.scissorBox();
+                GLStateCache::Color saved_clear_color = gl.clearColor();
+
+                // Only the bottom-left width x height corner of the pooled texture is in use.
+                // glClear ignores the viewport and the ImGui backend sets (and restores) its
+                // own, so the scissor is all that needs adjusting here.
+                gl.setClearColor(kClearColor);
+                if (damage.full) {
+                    gl.setScissorTest(true);
+                    gl.setScissorBox({ 0, 0, width, height });
+                    glClear(GL_COLOR_BUFFER_BIT);
+                    // Restores every binding it changes, so the shadow stays valid across it.
+                    ImGui_ImplOpenGL3_RenderDrawData(draw_data);
+                } else {
+                    copyForward(*previous, width, height);
+                    for (const ImRect &rect : damage.rects) {
+                        gl.setScissorTest(true);
+                        scissorTo(*draw_data, rect);
+                        glClear(GL_COLOR_BUFFER_BIT);
+                        renderClipped(draw_data, rect);
+                    }
+                }
 
-            auto *saved_ctx = ImGui::GetCurrentContext();
-            ImGui::SetCurrentContext(ctx_);
+                gl.setClearColor(saved_clear_color);
+                gl.setScissorBox(saved_scissor_box);
+                gl.setScissorTest(saved_scissor_test);
+            });
 
-            ImGuiIO &io = ImGui::GetIO();
-            io.DisplaySize = ImVec2(static_cast<float>(width), static_cast<float>(height));
-            io.DisplayFramebufferScale = ImVec2(1.0f, 1.0f);
-            io.DeltaTime = 1.0f / 60.0f;
+            GLsync ready_fence = nullptr;
+            if (render_on_worker_) {
+                ready_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                // Other contexts can only wait on a fence that has been flushed.
+                glFlush();
+            }
 
-            ImGui_ImplOpenGL3_NewFrame();
-            ImGui::NewFrame();
+            // Slint flips bottom-left textures, which moves the used corner to the top edge.
+            frame = RenderedFrame{
+                .target = &target,
+                .clip = { .x = 0, .y = target.height - height, .width = width, .height = height },
+                .ready_fence = ready_fence,
+                .damage_coverage = damage.coverage(draw_data->DisplaySize),
+                .damage_rects = static_cast<int>(damage.rects.size()),
+            };
+        }
 
-            scene_.build(app);
+        frame_cost_ = std::chrono::duration<float>(std::chrono::steady_clock::now() - work_start).count();
+        ImGui::SetCurrentContext(saved_ctx);
+        return frame;
+    }
 
-            ImGui::Render();
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    // Runs on the render side with ctx_ current: feeds ImGui the queued input and lays out the
+    // scene. The returned draw data stays valid until the next call.
+    ImDrawData *buildFrame(slint::ComponentHandle<App> &app, const FrameRequest &request)
+    {
+        ImGuiIO &io = ImGui::GetIO();
+        {
+            std::lock_guard lock(mailbox_->mutex);
+            for (auto &event : mailbox_->input)
+                event(io);
+            mailbox_->input.clear();
+        }
+        // ImGui works in logical pixels, like the pointer positions Slint forwards.
+        io.DisplaySize = ImVec2(request.width / request.scale_factor, request.height / request.scale_factor);
+        io.DisplayFramebufferScale = ImVec2(request.scale_factor, request.scale_factor);
+        io.DeltaTime = clock_.tick();
 
-            ImGui::SetCurrentContext(saved_ctx);
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui::NewFrame();
 
-            glViewport(saved_viewport[0], saved_viewport[1], saved_viewport[2], saved_viewport[3]);
-        });
+        scene_.build(app);
+
+        ImGui::Render();
+        return ImGui::GetDrawData();
+    }
+
+    // Draws the last built frame over what Slint rendered into the window, at the ImGui
+    // component's place. The draw data is re-targeted at the whole window: shifting DisplayPos by
+    // the component's origin moves the projection, and clamping the clip rects to the component
+    // keeps the scene inside it, so ImGui coordinates (and with them pointer input) stay
+    // relative to the component as in texture mode.
+    void drawToWindow(slint::ComponentHandle<App> &app)
+    {
+        if (!window_frame_)
+            return;
+
+        auto *saved_ctx = ImGui::GetCurrentContext();
+        ImGui::SetCurrentContext(ctx_);
+
+        ImDrawData *draw_data = ImGui::GetDrawData();
+        ImVec2 scale = draw_data->FramebufferScale;
+        ImVec2 size = ImGui::GetIO().DisplaySize;
+        for (ImDrawList *list : draw_data->CmdLists) {
+            for (ImDrawCmd &cmd : list->CmdBuffer) {
+                cmd.ClipRect.x = std::max(cmd.ClipRect.x, 0.0f);
+                cmd.ClipRect.y = std::max(cmd.ClipRect.y, 0.0f);
+                cmd.ClipRect.z = std::min(cmd.ClipRect.z, size.x);
+                cmd.ClipRect.w = std::min(cmd.ClipRect.w, size.y);
+            }
+        }
+
+        auto window = app->window().size();
+        int x = app->get_imgui_window_x();
+        int y = app->get_imgui_window_y();
+        int width = app->get_requested_texture_width();
+        int height = app->get_requested_texture_height();
+        draw_data->DisplayPos = ImVec2(-x / scale.x, -y / scale.y);
+        draw_data->DisplaySize = ImVec2(window.width / scale.x, window.height / scale.y);
+
+        auto &gl = glStateCache();
+        bool saved_scissor_test = gl.scissorTest();
+        GLStateCache::Box saved_scissor_box = gl.scissorBox();
+        GLStateCache::Color saved_clear_color = gl.clearColor();
+        gl.setScissorTest(true);
+        gl.setScissorBox({ x, static_cast<int>(window.height) - y - height, width, height });
+        gl.setClearColor(kClearColor);
+        glClear(GL_COLOR_BUFFER_BIT);
+        gl.setClearColor(saved_clear_color);
+        gl.setScissorBox(saved_scissor_box);
+        gl.setScissorTest(saved_scissor_test);
+        // Saves and restores everything it touches, Slint's framebuffer binding included.
+        ImGui_ImplOpenGL3_RenderDrawData(draw_data);
+
+        ImGui::SetCurrentContext(saved_ctx);
+    }
+
+    // A drag (any widget held with a mouse button down) or a wheel gesture, which counts as
+    // ongoing until the wheel has been still for kWheelGestureTimeout.
+    bool isInteracting()
+    {
+        const ImGuiContext &g = *ctx_;
+        auto now = std::chrono::steady_clock::now();
+        if (g.IO.MouseWheel != 0.0f || g.IO.MouseWheelH != 0.0f)
+            last_wheel_ = now;
+        interacting_ = (g.ActiveId != 0 && ImGui::IsAnyMouseDown()) || now - last_wheel_ < kWheelGestureTimeout;
+        return interacting_;
+    }
+
+    // Picks the ring texture for a width x height frame. Resizes go through the ring's pool,
+    // so they only allocate when growing past every texture seen so far.
+    SceneTexture &acquireTarget(int width, int height)
+    {
+        SceneTexture &target = texture_ring_.acquire(width, height, shrink_frames_ > 0);
+
+        if (shrink_frames_ > 0 && --shrink_frames_ == 0)
+            texture_ring_.trim();
+
+        return target;
+    }
+
+    void onResizeSettled()
+    {
+        resize_settled_ = true;
+        frame_pending_ = true;
+        requestRedraw();
+    }
+
+    // Textures created or updated by ImGui this frame (e.g. glyphs added to the font atlas) are
+    // only uploaded by ImGui_ImplOpenGL3_RenderDrawData, so such a frame can never be skipped.
+    static bool hasPendingTextureUpdates(const ImDrawData &draw_data)
+    {
+        if (draw_data.Textures == nullptr)
+            return false;
+        for (const ImTextureData *tex : *draw_data.Textures)
+            if (tex->Status != ImTextureStatus_OK)
+                return true;
+        return false;
+    }
+
+    // Starts the target off as a copy of the previous frame (same bottom-left region).
+    static void copyForward(const SceneTexture &source, int width, int height)
+    {
+        ScopedReadFrameBufferBinding activeReadFBO(source.fbo);
+        // glBlitFramebuffer honours the scissor test.
+        glStateCache().setScissorTest(false);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+
+    // Scissors to a rectangle given in ImGui display coordinates (top-left origin).
+    static void scissorTo(const ImDrawData &draw_data, const ImRect &rect)
+    {
+        ImVec2 pos = draw_data.DisplayPos;
+        ImVec2 scale = draw_data.FramebufferScale;
+        float fb_height = draw_data.DisplaySize.y * scale.y;
+        int x0 = static_cast<int>(std::floor((rect.Min.x - pos.x) * scale.x));
+        int x1 = static_cast<int>(std::ceil((rect.Max.x - pos.x) * scale.x));
+        int y0 = static_cast<int>(std::floor(fb_height - (rect.Max.y - pos.y) * scale.y));
+        int y1 = static_cast<int>(std::ceil(fb_height - (rect.Min.y - pos.y) * scale.y));
+        glStateCache().setScissorBox({ x0, y0, x1 - x0, y1 - y0 });
+    }
 
-        auto resultTexture = slint::Image::create_from_borrowed_gl_2d_rgba_texture(
-                next_texture_->texture,
-                { static_cast<uint32_t>(next_texture_->width),
-                  static_cast<uint32_t>(next_texture_->height) },
-                slint::Image::BorrowedOpenGLTextureOrigin::BottomLeft);
+    // Draws only what falls inside rect by narrowing every command's clip rectangle to it for
+    // the duration of the call; the backend skips commands whose clip rectangle ends up empty.
+    void renderClipped(ImDrawData *draw_data, const ImRect &rect)
+    {
+        saved_clip_rects_.clear();
+        for (ImDrawList *list : draw_data->CmdLists) {
+            for (ImDrawCmd &cmd : list->CmdBuffer) {
+                saved_clip_rects_.push_back(cmd.ClipRect);
+                cmd.ClipRect = ImVec4(std::max(cmd.ClipRect.x, rect.Min.x), std::max(cmd.ClipRect.y, rect.Min.y),
+                                      std::min(cmd.ClipRect.z, rect.Max.x), std::min(cmd.ClipRect.w, rect.Max.y));
+            }
+        }
 
-        std::swap(next_texture_, displayed_texture_);
+        ImGui_ImplOpenGL3_RenderDrawData(draw_data);
 
-        return resultTexture;
+        auto saved = saved_clip_rects_.begin();
+        for (ImDrawList *list : draw_data->CmdLists)
+            for (ImDrawCmd &cmd : list->CmdBuffer)
+                cmd.ClipRect = *saved++;
     }
 
     void teardown()
+    {
+        wake_timer_.reset();
+        resize_settle_timer_.reset();
+        scene_.invalidation().wakeWith(nullptr);
+
+        if (worker_) {
+            // Framebuffers only exist in the worker's context, so they must be released there.
+            worker_->post([this]() { teardownImGui(); });
+            worker_.reset();
+            worker_busy_ = false;
+            worker_app_.reset();
+            if (mailbox_->frame && mailbox_->frame->ready_fence)
+                glDeleteSync(mailbox_->frame->ready_fence);
+            mailbox_->frame.reset();
+            mailbox_->frame_done = false;
+        } else {
+            teardownImGui();
+        }
+    };
+
+    // Runs on the render side.
+    void teardownImGui()
     {
         scene_.teardown();
         ImGui_ImplOpenGL3_Shutdown();
         ImGui::DestroyContext(ctx_);
         ctx_ = nullptr;
-        displayed_texture_.reset();
-        next_texture_.reset();
-    };
+        damage_tracker_.invalidate();
+        texture_ring_.clear();
+    }
 
     slint::ComponentWeakHandle<App> app_weak_;
+    ImGuiRendererOptions options_;
     Scene scene_;
+    uint64_t built_generation_ = 0;
     bool input_pending_ = false;
 
+    static constexpr int kSettleFrames = 2;
+    FrameClock clock_;
+    std::unique_ptr<slint::Timer> wake_timer_ = nullptr;
+    bool frame_pending_ = false;
+    // held back by the resize debouncer until wake_timer_ fires
+    bool frame_held_ = false;
+    int settle_frames_ = 0;
+
+    static constexpr GLStateCache::Color kClearColor{ 0.1f, 0.1f, 0.12f, 1.0f };
     ImGuiContext *ctx_ = nullptr;
-    std::unique_ptr<SceneTexture> displayed_texture_ = nullptr;
-    std::unique_ptr<SceneTexture> next_texture_ = nullptr;
+    DamageTracker damage_tracker_;
+    std::vector<ImVec4> saved_clip_rects_;
+    RenderStats stats_;
+
+    static constexpr size_t kTexturePoolBudget = 64 * 1024 * 1024;
+    static constexpr std::chrono::milliseconds kResizeSettleDelay{ 500 };
+    SceneTextureRing texture_ring_{ kTexturePoolBudget };
+    std::unique_ptr<slint::Timer> resize_settle_timer_ = nullptr;
+    ResizeDebouncer resize_debouncer_{ options_.resize_debounce, options_.resize_max_interval };
+    int texture_width_ = 0;
+    int texture_height_ = 0;
+    bool resize_settled_ = false;
+    int shrink_frames_ = 0;
+
+    static constexpr std::chrono::milliseconds kWheelGestureTimeout{ 150 };
+    ResolutionScaler resolution_scaler_{ options_.frame_budget };
+    float frame_cost_ = 0.0f; // seconds spent building and drawing the last frame
+    std::chrono::steady_clock::time_point last_wheel_;
+    bool interacting_ = false;
+
+    std::unique_ptr<GLWorker> worker_ = nullptr;
+    bool render_on_worker_ = false;
+    std::unique_ptr<Mailbox> mailbox_ = std::make_unique<Mailbox>();
+    std::optional<slint::ComponentHandle<App>> worker_app_;
+
+    bool window_frame_ = false;
+    bool worker_busy_ = false;
 };
 
 class SceneDemo
@@ -294,6 +991,14 @@ public:
     void setup() {}
     void teardown() {}
 
+    void bind(slint::ComponentHandle<App> &app)
+    {
+        app->on_selected_color_changed([invalidation = invalidation_]() { invalidation->invalidate(); });
+        app->on_requested_texture_size_changed([invalidation = invalidation_]() { invalidation->invalidate(); });
+    }
+
+    SceneInvalidation &invalidation() { return *invalidation_; }
+
     bool needsUpdate(slint::ComponentHandle<App> &app)
     {
         auto new_state = State{
@@ -350,83 +1055,320 @@ private:
     };
 
     State state_;
+    std::shared_ptr<SceneInvalidation> invalidation_ = std::make_shared<SceneInvalidation>();
 };
 
 class SceneImPlot
 {
 public:
-    SceneImPlot() = default;
+    // build() only reads state that needsUpdate() updates, and the importer's and generator's
+    // atomic counters. What it writes back (the visible range, the live feed's view) is read by
+    // needsUpdate() only after the frame has been collected.
+    static constexpr bool kThreadSafeBuild = true;
+
+    // Plots the OHLC file named by SLINT_IMGUI_OHLC, or the built-in sample. CSV and TSV files
+    // are imported in the background, anything else is mapped in place. An import is also written
+    // to the OHLC file named by SLINT_IMGUI_OHLC_WRITE, if set, and plotted from it once it reads
+    // back the same. SLINT_IMGUI_TICKS=<rate> instead follows a synthetic live feed of that many
+    // ticks per second.
+    SceneImPlot()
+    {
+        if (const char *rate = std::getenv("SLINT_IMGUI_TICKS")) {
+            live_ = std::make_unique<LiveFeed>(std::max(1.0, std::atof(rate)), invalidation_);
+            label_ = "LIVE";
+            return;
+        }
+        if (const char *path = std::getenv("SLINT_IMGUI_OHLC")) {
+            auto extension = std::filesystem::path(path).extension();
+            if (extension == ".csv" || extension == ".tsv" || extension == ".txt") {
+                label_ = std::filesystem::path(path).stem().string();
+                // progress arrives on the import thread
+                importer_ = std::make_unique<OhlcCsvImporter>(path, [invalidation = invalidation_]() {
+                    invalidation->invalidate();
+                });
+                return;
+            }
+            plotFile(MappedOhlcFile::open(path));
+            if (file_)
+                label_ = std::filesystem::path(path).stem().string();
+        }
+        if (!file_)
+            loadSample(series_);
+    }
 
     void setup() {
         ctx_ = ImPlot::CreateContext();
     }
 
     void teardown() {
+        if (live_)
+            live_->depth.release();
         ImPlot::DestroyContext(ctx_);
         ctx_ = nullptr;
     }
 
-    bool needsUpdate([[maybe_unused]] slint::ComponentHandle<App> &app)
+    void bind(slint::ComponentHandle<App> &app)
+    {
+        app->on_requested_texture_size_changed([invalidation = invalidation_]() { invalidation->invalidate(); });
+    }
+
+    SceneInvalidation &invalidation() { return *invalidation_; }
+
+    bool needsUpdate(slint::ComponentHandle<App> &app)
     {
         auto new_state = State{
             .width = app->get_requested_texture_width(),
             .height = app->get_requested_texture_height()
         };
+        bool changed = false;
         if (state_.width != new_state.width || state_.height != new_state.height) {
             state_ = new_state;
+            changed = true;
+        }
+
+        if (live_) {
+            size_t first_changed = series_.size();
+            live_->ring->consumeAll([&](const Tick &tick) {
+                first_changed = std::min(first_changed, live_->aggregator.add(series_, tick));
+                live_->trades.push(tick.time, tick.price);
+                live_->book.add(tick, LiveFeed::kDepthColumns, [&](std::span<const float> column) {
+                    live_->depth.push(column);
+                    changed = true;
+                });
+            });
+            // redraw only for bars on screen, or when the view follows the newest bar
+            if (first_changed < series_.size()) {
+                double x = series_.xs()[first_changed];
+                bool following = !live_->placed || visible_max_ >= live_->last_x;
+                changed |= following || (x + live_->aggregator.period() >= visible_min_ && x <= visible_max_);
+            }
+            // the trade strip shows every trade
+            changed |= std::exchange(live_->trades_plotted, live_->trades.version()) != live_->trades.version();
+        }
+
+        if (conversion_.valid() && conversion_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            if (auto file = conversion_.get()) {
+                plotFile(std::move(file));
+                series_ = {};
+                volumes_ = {};
+            }
             return true;
         }
-        return false;
+
+        if (importer_) {
+            if (importer_->done()) {
+                if (auto imported = importer_->take()) {
+                    series_ = std::move(imported->series);
+                    volumes_ = std::move(imported->volumes);
+                    if (const char *path = std::getenv("SLINT_IMGUI_OHLC_WRITE"))
+                        writeImport(path);
+                }
+                importer_.reset();
+                return true;
+            }
+            // redraw the progress bar in whole percent steps
+            int percent = static_cast<int>(importer_->progress() * 100.0f);
+            changed |= std::exchange(import_percent_, percent) != percent;
+        }
+        return changed;
     }
 
     void build([[maybe_unused]] slint::ComponentHandle<App> &app)
     {
         ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_FirstUseEver);
-        ImGui::SetNextWindowSize(ImVec2(state_.width, state_.height), ImGuiCond_Always);
+        ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
         if (ImGui::Begin("ImPlot", nullptr, ImGuiWindowFlags_NoSavedSettings)) {
             ImGui::BulletText("You can create custom plotters or extend ImPlot using implot_internal.h.");
-            double dates[]  = {1546300800,1546387200,1546473600,1546560000,1546819200,1546905600,1546992000,1547078400,1547164800,1547424000,1547510400,1547596800,1547683200,1547769600,1547942400,1548028800,1548115200,1548201600,1548288000,1548374400,1548633600,1548720000,1548806400,1548892800,1548979200,1549238400,1549324800,1549411200,1549497600,1549584000,1549843200,1549929600,1550016000,1550102400,1550188800,1550361600,1550448000,1550534400,1550620800,1550707200,1550793600,1551052800,1551139200,1551225600,1551312000,1551398400,1551657600,1551744000,1551830400,1551916800,1552003200,1552262400,1552348800,1552435200,1552521600,1552608000,1552867200,1552953600,1553040000,1553126400,1553212800,1553472000,1553558400,1553644800,1553731200,1553817600,1554076800,1554163200,1554249600,1554336000,1554422400,1554681600,1554768000,1554854400,1554940800,1555027200,1555286400,1555372800,1555459200,1555545600,1555632000,1555891200,1555977600,1556064000,1556150400,1556236800,1556496000,1556582400,1556668800,1556755200,1556841600,1557100800,1557187200,1557273600,1557360000,1557446400,1557705600,1557792000,1557878400,1557964800,1558051200,1558310400,1558396800,1558483200,1558569600,1558656000,1558828800,1558915200,1559001600,1559088000,1559174400,1559260800,1559520000,1559606400,1559692800,1559779200,1559865600,1560124800,1560211200,1560297600,1560384000,1560470400,1560729600,1560816000,1560902400,1560988800,1561075200,1561334400,1561420800,1561507200,1561593600,1561680000,1561939200,1562025600,1562112000,1562198400,1562284800,1562544000,1562630400,1562716800,1562803200,1562889600,1563148800,1563235200,1563321600,1563408000,1563494400,1563753600,1563840000,1563926400,1564012800,1564099200,1564358400,1564444800,1564531200,1564617600,1564704000,1564963200,1565049600,1565136000,1565222400,1565308800,1565568000,1565654400,1565740800,1565827200,1565913600,1566172800,1566259200,1566345600,1566432000,1566518400,1566777600,1566864000,1566950400,1567036800,1567123200,1567296000,1567382400,1567468800,1567555200,1567641600,1567728000,1567987200,1568073600,1568160000,1568246400,1568332800,1568592000,1568678400,1568764800,1568851200,1568937600,1569196800,1569283200,1569369600,1569456000,1569542400,1569801600,1569888000,1569974400,1570060800,1570147200,1570406400,1570492800,1570579200,1570665600,1570752000,1571011200,1571097600,1571184000,1571270400,1571356800,1571616000,1571702400,1571788800,1571875200,1571961600};
-            double opens[]  = {1284.7,1319.9,1318.7,1328,1317.6,1321.6,1314.3,1325,1319.3,1323.1,1324.7,1321.3,1323.5,1322,1281.3,1281.95,1311.1,1315,1314,1313.1,1331.9,1334.2,1341.3,1350.6,1349.8,1346.4,1343.4,1344.9,1335.6,1337.9,1342.5,1337,1338.6,1337,1340.4,1324.65,1324.35,1349.5,1371.3,1367.9,1351.3,1357.8,1356.1,1356,1347.6,1339.1,1320.6,1311.8,1314,1312.4,1312.3,1323.5,1319.1,1327.2,1332.1,1320.3,1323.1,1328,1330.9,1338,1333,1335.3,1345.2,1341.1,1332.5,1314,1314.4,1310.7,1314,1313.1,1315,1313.7,1320,1326.5,1329.2,1314.2,1312.3,1309.5,1297.4,1293.7,1277.9,1295.8,1295.2,1290.3,1294.2,1298,1306.4,1299.8,1302.3,1297,1289.6,1302,1300.7,1303.5,1300.5,1303.2,1306,1318.7,1315,1314.5,1304.1,1294.7,1293.7,1291.2,1290.2,1300.4,1284.2,1284.25,1301.8,1295.9,1296.2,1304.4,1323.1,1340.9,1341,1348,1351.4,1351.4,1343.5,1342.3,1349,1357.6,1357.1,1354.7,1361.4,1375.2,1403.5,1414.7,1433.2,1438,1423.6,1424.4,1418,1399.5,1435.5,1421.25,1434.1,1412.4,1409.8,1412.2,1433.4,1418.4,1429,1428.8,1420.6,1441,1460.4,1441.7,1438.4,1431,1439.3,1427.4,1431.9,1439.5,1443.7,1425.6,1457.5,1451.2,1481.1,1486.7,1512.1,1515.9,1509.2,1522.3,1513,1526.6,1533.9,1523,1506.3,1518.4,1512.4,1508.8,1545.4,1537.3,1551.8,1549.4,1536.9,1535.25,1537.95,1535.2,1556,1561.4,1525.6,1516.4,1507,1493.9,1504.9,1506.5,1513.1,1506.5,1509.7,1502,1506.8,1521.5,1529.8,1539.8,1510.9,1511.8,1501.7,1478,1485.4,1505.6,1511.6,1518.6,1498.7,1510.9,1510.8,1498.3,1492,1497.7,1484.8,1494.2,1495.6,1495.6,1487.5,1491.1,1495.1,1506.4};
-            double highs[]  = {1284.75,1320.6,1327,1330.8,1326.8,1321.6,1326,1328,1325.8,1327.1,1326,1326,1323.5,1322.1,1282.7,1282.95,1315.8,1316.3,1314,1333.2,1334.7,1341.7,1353.2,1354.6,1352.2,1346.4,1345.7,1344.9,1340.7,1344.2,1342.7,1342.1,1345.2,1342,1350,1324.95,1330.75,1369.6,1374.3,1368.4,1359.8,1359,1357,1356,1353.4,1340.6,1322.3,1314.1,1316.1,1312.9,1325.7,1323.5,1326.3,1336,1332.1,1330.1,1330.4,1334.7,1341.1,1344.2,1338.8,1348.4,1345.6,1342.8,1334.7,1322.3,1319.3,1314.7,1316.6,1316.4,1315,1325.4,1328.3,1332.2,1329.2,1316.9,1312.3,1309.5,1299.6,1296.9,1277.9,1299.5,1296.2,1298.4,1302.5,1308.7,1306.4,1305.9,1307,1297.2,1301.7,1305,1305.3,1310.2,1307,1308,1319.8,1321.7,1318.7,1316.2,1305.9,1295.8,1293.8,1293.7,1304.2,1302,1285.15,1286.85,1304,1302,1305.2,1323,1344.1,1345.2,1360.1,1355.3,1363.8,1353,1344.7,1353.6,1358,1373.6,1358.2,1369.6,1377.6,1408.9,1425.5,1435.9,1453.7,1438,1426,1439.1,1418,1435,1452.6,1426.65,1437.5,1421.5,1414.1,1433.3,1441.3,1431.4,1433.9,1432.4,1440.8,1462.3,1467,1443.5,1444,1442.9,1447,1437.6,1440.8,1445.7,1447.8,1458.2,1461.9,1481.8,1486.8,1522.7,1521.3,1521.1,1531.5,1546.1,1534.9,1537.7,1538.6,1523.6,1518.8,1518.4,1514.6,1540.3,1565,1554.5,1556.6,1559.8,1541.9,1542.9,1540.05,1558.9,1566.2,1561.9,1536.2,1523.8,1509.1,1506.2,1532.2,1516.6,1519.7,1515,1519.5,1512.1,1524.5,1534.4,1543.3,1543.3,1542.8,1519.5,1507.2,1493.5,1511.4,1525.8,1522.2,1518.8,1515.3,1518,1522.3,1508,1501.5,1503,1495.5,1501.1,1497.9,1498.7,1492.1,1499.4,1506.9,1520.9};
-            double lows[]   = {1282.85,1315,1318.7,1309.6,1317.6,1312.9,1312.4,1319.1,1319,1321,1318.1,1321.3,1319.9,1312,1280.5,1276.15,1308,1309.9,1308.5,1312.3,1329.3,1333.1,1340.2,1347,1345.9,1338,1340.8,1335,1332,1337.9,1333,1336.8,1333.2,1329.9,1340.4,1323.85,1324.05,1349,1366.3,1351.2,1349.1,1352.4,1350.7,1344.3,1338.9,1316.3,1308.4,1306.9,1309.6,1306.7,1312.3,1315.4,1319,1327.2,1317.2,1320,1323,1328,1323,1327.8,1331.7,1335.3,1336.6,1331.8,1311.4,1310,1309.5,1308,1310.6,1302.8,1306.6,1313.7,1320,1322.8,1311,1312.1,1303.6,1293.9,1293.5,1291,1277.9,1294.1,1286,1289.1,1293.5,1296.9,1298,1299.6,1292.9,1285.1,1288.5,1296.3,1297.2,1298.4,1298.6,1302,1300.3,1312,1310.8,1301.9,1292,1291.1,1286.3,1289.2,1289.9,1297.4,1283.65,1283.25,1292.9,1295.9,1290.8,1304.2,1322.7,1336.1,1341,1343.5,1345.8,1340.3,1335.1,1341.5,1347.6,1352.8,1348.2,1353.7,1356.5,1373.3,1398,1414.7,1427,1416.4,1412.7,1420.1,1396.4,1398.8,1426.6,1412.85,1400.7,1406,1399.8,1404.4,1415.5,1417.2,1421.9,1415,1413.7,1428.1,1434,1435.7,1427.5,1429.4,1423.9,1425.6,1427.5,1434.8,1422.3,1412.1,1442.5,1448.8,1468.2,1484.3,1501.6,1506.2,1498.6,1488.9,1504.5,1518.3,1513.9,1503.3,1503,1506.5,1502.1,1503,1534.8,1535.3,1541.4,1528.6,1525.6,1535.25,1528.15,1528,1542.6,1514.3,1510.7,1505.5,1492.1,1492.9,1496.8,1493.1,1503.4,1500.9,1490.7,1496.3,1505.3,1505.3,1517.9,1507.4,1507.1,1493.3,1470.5,1465,1480.5,1501.7,1501.4,1493.3,1492.1,1505.1,1495.7,1478,1487.1,1480.8,1480.6,1487,1488.3,1484.8,1484,1490.7,1490.4,1503.1};
-            double closes[] = {1283.35,1315.3,1326.1,1317.4,1321.5,1317.4,1323.5,1319.2,1321.3,1323.3,1319.7,1325.1,1323.6,1313.8,1282.05,1279.05,1314.2,1315.2,1310.8,1329.1,1334.5,1340.2,1340.5,1350,1347.1,1344.3,1344.6,1339.7,1339.4,1343.7,1337,1338.9,1340.1,1338.7,1346.8,1324.25,1329.55,1369.6,1372.5,1352.4,1357.6,1354.2,1353.4,1346,1341,1323.8,1311.9,1309.1,1312.2,1310.7,1324.3,1315.7,1322.4,1333.8,1319.4,1327.1,1325.8,1330.9,1325.8,1331.6,1336.5,1346.7,1339.2,1334.7,1313.3,1316.5,1312.4,1313.4,1313.3,1312.2,1313.7,1319.9,1326.3,1331.9,1311.3,1313.4,1309.4,1295.2,1294.7,1294.1,1277.9,1295.8,1291.2,1297.4,1297.7,1306.8,1299.4,1303.6,1302.2,1289.9,1299.2,1301.8,1303.6,1299.5,1303.2,1305.3,1319.5,1313.6,1315.1,1303.5,1293,1294.6,1290.4,1291.4,1302.7,1301,1284.15,1284.95,1294.3,1297.9,1304.1,1322.6,1339.3,1340.1,1344.9,1354,1357.4,1340.7,1342.7,1348.2,1355.1,1355.9,1354.2,1362.1,1360.1,1408.3,1411.2,1429.5,1430.1,1426.8,1423.4,1425.1,1400.8,1419.8,1432.9,1423.55,1412.1,1412.2,1412.8,1424.9,1419.3,1424.8,1426.1,1423.6,1435.9,1440.8,1439.4,1439.7,1434.5,1436.5,1427.5,1432.2,1433.3,1441.8,1437.8,1432.4,1457.5,1476.5,1484.2,1519.6,1509.5,1508.5,1517.2,1514.1,1527.8,1531.2,1523.6,1511.6,1515.7,1515.7,1508.5,1537.6,1537.2,1551.8,1549.1,1536.9,1529.4,1538.05,1535.15,1555.9,1560.4,1525.5,1515.5,1511.1,1499.2,1503.2,1507.4,1499.5,1511.5,1513.4,1515.8,1506.2,1515.1,1531.5,1540.2,1512.3,1515.2,1506.4,1472.9,1489,1507.9,1513.8,1512.9,1504.4,1503.9,1512.8,1500.9,1488.7,1497.6,1483.5,1494,1498.3,1494.1,1488.1,1487.5,1495.7,1504.7,1505.3};
+            if (importer_)
+                ImGui::ProgressBar(importer_->progress(), ImVec2(-1, 0), "Importing...");
+            if (conversion_.valid())
+                ImGui::TextUnformatted("Writing the OHLC file...");
+            if (live_ && live_->generator.dropped() > 0)
+                ImGui::TextColored(ImVec4(1, 0.4f, 0.4f, 1), "%llu ticks dropped", static_cast<unsigned long long>(live_->generator.dropped()));
             static bool tooltip = true;
             ImGui::Checkbox("Show Tooltip", &tooltip);
             ImGui::SameLine();
+            static bool indicators = true;
+            ImGui::Checkbox("Indicators", &indicators);
+            ImGui::SameLine();
+            static bool overview = true;
+            ImGui::Checkbox("Overview", &overview);
+            ImGui::SameLine();
             static ImVec4 bullCol = ImVec4(0.000f, 1.000f, 0.441f, 1.000f);
             static ImVec4 bearCol = ImVec4(0.853f, 0.050f, 0.310f, 1.000f);
             ImGui::SameLine(); ImGui::ColorEdit4("##Bull", &bullCol.x, ImGuiColorEditFlags_NoInputs);
             ImGui::SameLine(); ImGui::ColorEdit4("##Bear", &bearCol.x, ImGuiColorEditFlags_NoInputs);
             ImPlot::GetStyle().UseLocalTime = false;
 
-            if (ImPlot::BeginPlot("Candlestick Chart",ImVec2(-1,-1))) {
+            int strips = (overview ? 1 : 0) + (live_ ? 1 : 0);
+            float chart_height = strips > 0 ? -strips * (kStripHeight + ImGui::GetStyle().ItemSpacing.y) : -1;
+            float chart_width = live_ ? -kDepthWidth - ImGui::GetStyle().ItemSpacing.x : -1;
+            if (ImPlot::BeginPlot("Candlestick Chart",ImVec2(chart_width,chart_height))) {
                 ImPlot::SetupAxes(nullptr,nullptr,0,ImPlotAxisFlags_AutoFit|ImPlotAxisFlags_RangeFit);
-                ImPlot::SetupAxesLimits(1546300800, 1571961600, 1250, 1600);
                 ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Time);
-                ImPlot::SetupAxisLimitsConstraints(ImAxis_X1, 1546300800, 1571961600);
-                ImPlot::SetupAxisZoomConstraints(ImAxis_X1, 60*60*24*14, 1571961600-1546300800);
-                ImPlot::SetupAxisFormat(ImAxis_Y1, "$%.0f");
-                plotCandlestick("GOOGL",dates, opens, closes, lows, highs, 218, tooltip, 0.25f, bullCol, bearCol);
+                if (indicators) {
+                    ImPlot::SetupAxis(ImAxis_Y2, "RSI", ImPlotAxisFlags_AuxDefault|ImPlotAxisFlags_Lock);
+                    ImPlot::SetupAxisLimits(ImAxis_Y2, 0, 100, ImPlotCond_Always);
+                }
+                // mapped files are plotted straight from the mapping
+                auto plotSeries = [&](const auto &series) {
+                    if (live_) {
+                        followLiveFeed();
+                    } else if (!series.empty()) {
+                        // framed by the data: all bars with half a bar to spare, zooming in down to
+                        // kMinZoomBars of them; y starts at the range of all bars, once per series
+                        const double *xs = series.xs().data();
+                        size_t count = series.size();
+                        double spacing = count > 1 ? xs[1] - xs[0] : 1.0;
+                        double first = xs[0] - 0.5 * spacing, last = xs[count - 1] + 0.5 * spacing;
+                        if (std::exchange(placed_lineage_, series.lineage()) != series.lineage()) {
+                            CandleRenderer::Columns base{ xs, series.opens().data(), series.closes().data(), series.lows().data(), series.highs().data() };
+                            pyramid_.update(base, count, spacing, series.version(), series.lineage());
+                            auto extent = pyramid_.extent(base, 0, count);
+                            if (!(extent.low < extent.high)) {
+                                extent.low -= 1.0;
+                                extent.high += 1.0;
+                            }
+                            ImPlot::SetupAxesLimits(first, last, extent.low, extent.high, ImPlotCond_Always);
+                        }
+                        ImPlot::SetupAxisLimitsConstraints(ImAxis_X1, first, last);
+                        ImPlot::SetupAxisZoomConstraints(ImAxis_X1, std::min(kMinZoomBars * spacing, last - first), last - first);
+                    }
+                    ImPlot::SetupAxisFormat(ImAxis_Y1, "$%.0f");
+                    plotCandlestick(label_.c_str(), series.xs(), series.opens(), series.closes(), series.lows(), series.highs(), series.version(), series.lineage(), file_ != nullptr, tooltip, 0.25f, bullCol, bearCol);
+                };
+                if (file_)
+                    plotSeries(*file_);
+                else
+                    plotSeries(series_);
+                if (indicators) {
+                    if (file_)
+                        plotIndicators(file_->xs(), file_->opens(), file_->closes(), file_->lows(), file_->highs(), file_->volumes().data(), true);
+                    else
+                        plotIndicators(series_.xs(), series_.opens(), series_.closes(), series_.lows(), series_.highs(), volumes_.empty() ? nullptr : volumes_.data(), false);
+                }
+                ImPlotRect limits = ImPlot::GetPlotLimits();
+                visible_min_ = limits.X.Min;
+                visible_max_ = limits.X.Max;
+                visible_low_ = limits.Y.Min;
+                visible_high_ = limits.Y.Max;
                 ImPlot::EndPlot();
             }
+            if (live_) {
+                ImGui::SameLine();
+                plotDepth(chart_height);
+            }
+            if (overview) {
+                if (file_)
+                    plotOverview(file_->xs(), file_->closes(), file_->version(), true);
+                else
+                    plotOverview(series_.xs(), series_.closes(), series_.version(), false);
+            }
+            if (live_)
+                plotTrades();
         }
         ImGui::End();
     }
 
 private:
-    template <typename T>
-    int BinarySearch(const T* arr, int l, int r, T x) {
-        if (r >= l) {
-            int mid = l + (r - l) / 2;
-            if (arr[mid] == x)
-                return mid;
-            if (arr[mid] > x)
-                return BinarySearch(arr, l, mid - 1, x);
-            return BinarySearch(arr, mid + 1, r, x);
+    // The synthetic feed: the generator thread pushes into the ring and invalidates the scene,
+    // needsUpdate() drains it into series_ on the UI thread.
+    struct LiveFeed
+    {
+        using Ring = SpscRing<Tick, 1 << 18>;
+        static constexpr double kBarPeriod = 1.0;
+        // depth snapshots: 256 levels 5 cents apart, every 250 ms, for the last 128 s
+        static constexpr int kDepthColumns = 512;
+        static constexpr int kDepthLevels = 256;
+
+        LiveFeed(double ticks_per_second, std::shared_ptr<SceneInvalidation> invalidation)
+            : generator(*ring, ticks_per_second, [invalidation = std::move(invalidation)]() { invalidation->invalidate(); })
+        {
+        }
+
+        std::unique_ptr<Ring> ring = std::make_unique<Ring>();
+        BarAggregator aggregator{ kBarPeriod };
+        RingSeries<1 << 12> trades;
+        uint64_t trades_plotted = 0;
+        SyntheticOrderBook book{ kDepthLevels, 0.05, 0.25 };
+        ScrollingHeatmap depth{ kDepthColumns, kDepthLevels };
+        bool placed = false;
+        double last_x = INFINITY;
+        // last, so it stops producing before anything it uses goes away
+        SyntheticTickGenerator<Ring> generator;
+    };
+
+    // Shows the last couple of minutes once the first bar arrives, then scrolls the view along
+    // with new bars as long as the newest bar is in view.
+    void followLiveFeed()
+    {
+        if (series_.empty())
+            return;
+        double period = live_->aggregator.period();
+        double last = series_.xs().back();
+        if (!live_->placed) {
+            ImPlot::SetupAxisLimits(ImAxis_X1, last - 120 * period, last + 10 * period, ImPlotCond_Always);
+            live_->placed = true;
+        } else if (last > live_->last_x && visible_max_ >= live_->last_x) {
+            double shift = last - live_->last_x;
+            ImPlot::SetupAxisLimits(ImAxis_X1, visible_min_ + shift, visible_max_ + shift, ImPlotCond_Always);
         }
-        return -1;
+        live_->last_x = last;
     }
-    void plotCandlestick(const char* label_id, const double* xs, const double* opens, const double* closes, const double* lows, const double* highs, int count, bool tooltip, float width_percent, ImVec4 bullCol, ImVec4 bearCol) {
+
+    // Daily GOOGL bars for 2019, the dataset of the ImPlot demo.
+    static void loadSample(OhlcSeries &series)
+    {
+        static constexpr double dates[]  = {1546300800,1546387200,1546473600,1546560000,1546819200,1546905600,1546992000,1547078400,1547164800,1547424000,1547510400,1547596800,1547683200,1547769600,1547942400,1548028800,1548115200,1548201600,1548288000,1548374400,1548633600,1548720000,1548806400,1548892800,1548979200,1549238400,1549324800,1549411200,1549497600,1549584000,1549843200,1549929600,1550016000,1550102400,1550188800,1550361600,1550448000,1550534400,1550620800,1550707200,1550793600,1551052800,1551139200,1551225600,1551312000,1551398400,1551657600,1551744000,1551830400,1551916800,1552003200,1552262400,1552348800,1552435200,1552521600,1552608000,1552867200,1552953600,1553040000,1553126400,1553212800,1553472000,1553558400,1553644800,1553731200,1553817600,1554076800,1554163200,1554249600,1554336000,1554422400,1554681600,1554768000,1554854400,1554940800,1555027200,1555286400,1555372800,1555459200,1555545600,1555632000,1555891200,1555977600,1556064000,1556150400,1556236800,1556496000,1556582400,1556668800,1556755200,1556841600,1557100800,1557187200,1557273600,1557360000,1557446400,1557705600,1557792000,1557878400,1557964800,1558051200,1558310400,1558396800,1558483200,1558569600,1558656000,1558828800,1558915200,1559001600,1559088000,1559174400,1559260800,1559520000,1559606400,1559692800,1559779200,1559865600,1560124800,1560211200,1560297600,1560384000,1560470400,1560729600,1560816000,1560902400,1560988800,1561075200,1561334400,1561420800,1561507200,1561593600,1561680000,1561939200,1562025600,1562112000,1562198400,1562284800,1562544000,1562630400,1562716800,1562803200,1562889600,1563148800,1563235200,1563321600,1563408000,1563494400,1563753600,1563840000,1563926400,1564012800,1564099200,1564358400,1564444800,1564531200,1564617600,1564704000,1564963200,1565049600,1565136000,1565222400,1565308800,1565568000,1565654400,1565740800,1565827200,1565913600,1566172800,1566259200,1566345600,1566432000,1566518400,1566777600,1566864000,1566950400,1567036800,1567123200,1567296000,1567382400,1567468800,1567555200,1567641600,1567728000,1567987200,1568073600,1568160000,1568246400,1568332800,1568592000,1568678400,1568764800,1568851200,1568937600,1569196800,1569283200,1569369600,1569456000,1569542400,1569801600,1569888000,1569974400,1570060800,1570147200,1570406400,1570492800,1570579200,1570665600,1570752000,1571011200,1571097600,1571184000,1571270400,1571356800,1571616000,1571702400,1571788800,1571875200,1571961600};
+        static constexpr double opens[]  = {1284.7,1319.9,1318.7,1328,1317.6,1321.6,1314.3,1325,1319.3,1323.1,1324.7,1321.3,1323.5,1322,1281.3,1281.95,1311.1,1315,1314,1313.1,1331.9,1334.2,1341.3,1350.6,1349.8,1346.4,1343.4,1344.9,1335.6,1337.9,1342.5,1337,1338.6,1337,1340.4,1324.65,1324.35,1349.5,1371.3,1367.9,1351.3,1357.8,1356.1,1356,1347.6,1339.1,1320.6,1311.8,1314,1312.4,1312.3,1323.5,1319.1,1327.2,1332.1,1320.3,1323.1,1328,1330.9,1338,1333,1335.3,1345.2,1341.1,1332.5,1314,1314.4,1310.7,1314,1313.1,1315,1313.7,1320,1326.5,1329.2,1314.2,1312.3,1309.5,1297.4,1293.7,1277.9,1295.8,1295.2,1290.3,1294.2,1298,1306.4,1299.8,1302.3,1297,1289.6,1302,1300.7,1303.5,1300.5,1303.2,1306,1318.7,1315,1314.5,1304.1,1294.7,1293.7,1291.2,1290.2,1300.4,1284.2,1284.25,1301.8,1295.9,1296.2,1304.4,1323.1,1340.9,1341,1348,1351.4,1351.4,1343.5,1342.3,1349,1357.6,1357.1,1354.7,1361.4,1375.2,1403.5,1414.7,1433.2,1438,1423.6,1424.4,1418,1399.5,1435.5,1421.25,1434.1,1412.4,1409.8,1412.2,1433.4,1418.4,1429,1428.8,1420.6,1441,1460.4,1441.7,1438.4,1431,1439.3,1427.4,1431.9,1439.5,1443.7,1425.6,1457.5,1451.2,1481.1,1486.7,1512.1,1515.9,1509.2,1522.3,1513,1526.6,1533.9,1523,1506.3,1518.4,1512.4,1508.8,1545.4,1537.3,1551.8,1549.4,1536.9,1535.25,1537.95,1535.2,1556,1561.4,1525.6,1516.4,1507,1493.9,1504.9,1506.5,1513.1,1506.5,1509.7,1502,1506.8,1521.5,1529.8,1539.8,1510.9,1511.8,1501.7,1478,1485.4,1505.6,1511.6,1518.6,1498.7,1510.9,1510.8,1498.3,1492,1497.7,1484.8,1494.2,1495.6,1495.6,1487.5,1491.1,1495.1,1506.4};
+        static constexpr double highs[]  = {1284.75,1320.6,1327,1330.8,1326.8,1321.6,1326,1328,1325.8,1327.1,1326,1326,1323.5,1322.1,1282.7,1282.95,1315.8,1316.3,1314,1333.2,1334.7,1341.7,1353.2,1354.6,1352.2,1346.4,1345.7,1344.9,1340.7,1344.2,1342.7,1342.1,1345.2,1342,1350,1324.95,1330.75,1369.6,1374.3,1368.4,1359.8,1359,1357,1356,1353.4,1340.6,1322.3,1314.1,1316.1,1312.9,1325.7,1323.5,1326.3,1336,1332.1,1330.1,1330.4,1334.7,1341.1,1344.2,1338.8,1348.4,1345.6,1342.8,1334.7,1322.3,1319.3,1314.7,1316.6,1316.4,1315,1325.4,1328.3,1332.2,1329.2,1316.9,1312.3,1309.5,1299.6,1296.9,1277.9,1299.5,1296.2,1298.4,1302.5,1308.7,1306.4,1305.9,1307,1297.2,1301.7,1305,1305.3,1310.2,1307,1308,1319.8,1321.7,1318.7,1316.2,1305.9,1295.8,1293.8,1293.7,1304.2,1302,1285.15,1286.85,1304,1302,1305.2,1323,1344.1,1345.2,1360.1,1355.3,1363.8,1353,1344.7,1353.6,1358,1373.6,1358.2,1369.6,1377.6,1408.9,1425.5,1435.9,1453.7,1438,1426,1439.1,1418,1435,1452.6,1426.65,1437.5,1421.5,1414.1,1433.3,1441.3,1431.4,1433.9,1432.4,1440.8,1462.3,1467,1443.5,1444,1442.9,1447,1437.6,1440.8,1445.7,1447.8,1458.2,1461.9,1481.8,1486.8,1522.7,1521.3,1521.1,1531.5,1546.1,1534.9,1537.7,1538.6,1523.6,1518.8,1518.4,1514.6,1540.3,1565,1554.5,1556.6,1559.8,1541.9,1542.9,1540.05,1558.9,1566.2,1561.9,1536.2,1523.8,1509.1,1506.2,1532.2,1516.6,1519.7,1515,1519.5,1512.1,1524.5,1534.4,1543.3,1543.3,1542.8,1519.5,1507.2,1493.5,1511.4,1525.8,1522.2,1518.8,1515.3,1518,1522.3,1508,1501.5,1503,1495.5,1501.1,1497.9,1498.7,1492.1,1499.4,1506.9,1520.9};
+        static constexpr double lows[]   = {1282.85,1315,1318.7,1309.6,1317.6,1312.9,1312.4,1319.1,1319,1321,1318.1,1321.3,1319.9,1312,1280.5,1276.15,1308,1309.9,1308.5,1312.3,1329.3,1333.1,1340.2,1347,1345.9,1338,1340.8,1335,1332,1337.9,1333,1336.8,1333.2,1329.9,1340.4,1323.85,1324.05,1349,1366.3,1351.2,1349.1,1352.4,1350.7,1344.3,1338.9,1316.3,1308.4,1306.9,1309.6,1306.7,1312.3,1315.4,1319,1327.2,1317.2,1320,1323,1328,1323,1327.8,1331.7,1335.3,1336.6,1331.8,1311.4,1310,1309.5,1308,1310.6,1302.8,1306.6,1313.7,1320,1322.8,1311,1312.1,1303.6,1293.9,1293.5,1291,1277.9,1294.1,1286,1289.1,1293.5,1296.9,1298,1299.6,1292.9,1285.1,1288.5,1296.3,1297.2,1298.4,1298.6,1302,1300.3,1312,1310.8,1301.9,1292,1291.1,1286.3,1289.2,1289.9,1297.4,1283.65,1283.25,1292.9,1295.9,1290.8,1304.2,1322.7,1336.1,1341,1343.5,1345.8,1340.3,1335.1,1341.5,1347.6,1352.8,1348.2,1353.7,1356.5,1373.3,1398,1414.7,1427,1416.4,1412.7,1420.1,1396.4,1398.8,1426.6,1412.85,1400.7,1406,1399.8,1404.4,1415.5,1417.2,1421.9,1415,1413.7,1428.1,1434,1435.7,1427.5,1429.4,1423.9,1425.6,1427.5,1434.8,1422.3,1412.1,1442.5,1448.8,1468.2,1484.3,1501.6,1506.2,1498.6,1488.9,1504.5,1518.3,1513.9,1503.3,1503,1506.5,1502.1,1503,1534.8,1535.3,1541.4,1528.6,1525.6,1535.25,1528.15,1528,1542.6,1514.3,1510.7,1505.5,1492.1,1492.9,1496.8,1493.1,1503.4,1500.9,1490.7,1496.3,1505.3,1505.3,1517.9,1507.4,1507.1,1493.3,1470.5,1465,1480.5,1501.7,1501.4,1493.3,1492.1,1505.1,1495.7,1478,1487.1,1480.8,1480.6,1487,1488.3,1484.8,1484,1490.7,1490.4,1503.1};
+        static constexpr double closes[] = {1283.35,1315.3,1326.1,1317.4,1321.5,1317.4,1323.5,1319.2,1321.3,1323.3,1319.7,1325.1,1323.6,1313.8,1282.05,1279.05,1314.2,1315.2,1310.8,1329.1,1334.5,1340.2,1340.5,1350,1347.1,1344.3,1344.6,1339.7,1339.4,1343.7,1337,1338.9,1340.1,1338.7,1346.8,1324.25,1329.55,1369.6,1372.5,1352.4,1357.6,1354.2,1353.4,1346,1341,1323.8,1311.9,1309.1,1312.2,1310.7,1324.3,1315.7,1322.4,1333.8,1319.4,1327.1,1325.8,1330.9,1325.8,1331.6,1336.5,1346.7,1339.2,1334.7,1313.3,1316.5,1312.4,1313.4,1313.3,1312.2,1313.7,1319.9,1326.3,1331.9,1311.3,1313.4,1309.4,1295.2,1294.7,1294.1,1277.9,1295.8,1291.2,1297.4,1297.7,1306.8,1299.4,1303.6,1302.2,1289.9,1299.2,1301.8,1303.6,1299.5,1303.2,1305.3,1319.5,1313.6,1315.1,1303.5,1293,1294.6,1290.4,1291.4,1302.7,1301,1284.15,1284.95,1294.3,1297.9,1304.1,1322.6,1339.3,1340.1,1344.9,1354,1357.4,1340.7,1342.7,1348.2,1355.1,1355.9,1354.2,1362.1,1360.1,1408.3,1411.2,1429.5,1430.1,1426.8,1423.4,1425.1,1400.8,1419.8,1432.9,1423.55,1412.1,1412.2,1412.8,1424.9,1419.3,1424.8,1426.1,1423.6,1435.9,1440.8,1439.4,1439.7,1434.5,1436.5,1427.5,1432.2,1433.3,1441.8,1437.8,1432.4,1457.5,1476.5,1484.2,1519.6,1509.5,1508.5,1517.2,1514.1,1527.8,1531.2,1523.6,1511.6,1515.7,1515.7,1508.5,1537.6,1537.2,1551.8,1549.1,1536.9,1529.4,1538.05,1535.15,1555.9,1560.4,1525.5,1515.5,1511.1,1499.2,1503.2,1507.4,1499.5,1511.5,1513.4,1515.8,1506.2,1515.1,1531.5,1540.2,1512.3,1515.2,1506.4,1472.9,1489,1507.9,1513.8,1512.9,1504.4,1503.9,1512.8,1500.9,1488.7,1497.6,1483.5,1494,1498.3,1494.1,1488.1,1487.5,1495.7,1504.7,1505.3};
+        series.load(dates, opens, highs, lows, closes);
+    }
+
+    // Plots file, if any, from now on, with its stored pyramid levels.
+    void plotFile(std::unique_ptr<MappedOhlcFile> file) {
+        if (!file)
+            return;
+        file_ = std::move(file);
+        auto lod = file_->lod();
+        if (!lod.empty())
+            pyramid_.adopt(file_->xs().data(), file_->size(), file_->spacing(), lod, file_->version(), file_->lineage());
+    }
+
+    // Writes the imported series and its pyramid to path and maps the file back on a thread of its
+    // own, which reads series_ and volumes_ meanwhile; needsUpdate() leaves them alone until it is
+    // done. Only a file that holds exactly what was written then replaces the series; otherwise
+    // the series stays on screen.
+    void writeImport(const char *path) {
+        conversion_ = std::async(std::launch::async, [this, path = std::string(path), invalidation = invalidation_]() {
+            auto file = writeAndMap(path.c_str(), series_, volumes_);
+            invalidation->invalidate();
+            return file;
+        });
+    }
+
+    static std::unique_ptr<MappedOhlcFile> writeAndMap(const char *path, const OhlcSeries &series, std::span<const double> volumes) {
+        CandleRenderer::Columns columns{ series.xs().data(), series.opens().data(), series.closes().data(), series.lows().data(), series.highs().data() };
+        OhlcPyramid lod;
+        lod.build(columns, series.size(), series.size() > 1 ? series.xs()[1] - series.xs()[0] : 1.0);
+        if (!writeOhlcFile(path, series, volumes, &lod))
+            return nullptr;
+        auto file = MappedOhlcFile::open(path);
+        if (!file)
+            return nullptr;
+        if (!file->holds(series, volumes, &lod)) {
+            std::println(stderr, "{} does not read back what was written to it", path);
+            return nullptr;
+        }
+        std::println(stderr, "Wrote {} candles and {} merged levels to {}", series.size(), lod.levels() - 1, path);
+        return file;
+    }
+
+    void plotCandlestick(const char* label_id, std::span<const double> x_span, std::span<const double> open_span, std::span<const double> close_span, std::span<const double> low_span, std::span<const double> high_span, uint64_t version, uint64_t lineage, bool mapped, bool tooltip, float width_percent, ImVec4 bullCol, ImVec4 bearCol) {
+        const double *xs = x_span.data(), *opens = open_span.data(), *closes = close_span.data(), *lows = low_span.data(), *highs = high_span.data();
+        int count = static_cast<int>(x_span.size());
 
         // get ImGui window DrawList
         ImDrawList* draw_list = ImPlot::GetPlotDrawList();
@@ -436,18 +1378,18 @@ private:
         // custom tool
         if (ImPlot::IsPlotHovered() && tooltip) {
             ImPlotPoint mouse   = ImPlot::GetPlotMousePos();
-            mouse.x             = ImPlot::RoundTime(ImPlotTime::FromDouble(mouse.x), ImPlotTimeUnit_Day).ToDouble();
-            float  tool_l       = ImPlot::PlotToPixels(mouse.x - half_width * 1.5, mouse.y).x;
-            float  tool_r       = ImPlot::PlotToPixels(mouse.x + half_width * 1.5, mouse.y).x;
-            float  tool_t       = ImPlot::GetPlotPos().y;
-            float  tool_b       = tool_t + ImPlot::GetPlotSize().y;
-            ImPlot::PushPlotClipRect();
-            draw_list->AddRectFilled(ImVec2(tool_l, tool_t), ImVec2(tool_r, tool_b), IM_COL32(128,128,128,64));
-            ImPlot::PopPlotClipRect();
-            // find mouse location index
-            int idx = BinarySearch(xs, 0, count - 1, mouse.x);
-            // render tool tip (won't be affected by plot clip rect)
-            if (idx != -1) {
+            // snap to the candle closest to the mouse, gaps (weekends, nights) included
+            auto nearest = nearestIndex(xs, count, mouse.x);
+            if (nearest) {
+                size_t idx          = *nearest;
+                float  tool_l       = ImPlot::PlotToPixels(xs[idx] - half_width * 1.5, mouse.y).x;
+                float  tool_r       = ImPlot::PlotToPixels(xs[idx] + half_width * 1.5, mouse.y).x;
+                float  tool_t       = ImPlot::GetPlotPos().y;
+                float  tool_b       = tool_t + ImPlot::GetPlotSize().y;
+                ImPlot::PushPlotClipRect();
+                draw_list->AddRectFilled(ImVec2(tool_l, tool_t), ImVec2(tool_r, tool_b), IM_COL32(128,128,128,64));
+                ImPlot::PopPlotClipRect();
+                // render tool tip (won't be affected by plot clip rect)
                 ImGui::BeginTooltip();
                 char buff[32];
                 ImPlot::FormatDate(ImPlotTime::FromDouble(xs[idx]),buff,32,ImPlotDateFmt_DayMoYr,ImPlot::GetStyle().UseISO8601);
@@ -464,22 +1406,61 @@ private:
         if (ImPlot::BeginItem(label_id)) {
             // override legend icon color
             ImPlot::GetCurrentItem()->Color = IM_COL32(64,64,64,255);
-            // fit data if requested
-            if (ImPlot::FitThisFrame()) {
-                for (int i = 0; i < count; ++i) {
-                    ImPlot::FitPoint(ImPlotPoint(xs[i], lows[i]));
-                    ImPlot::FitPoint(ImPlotPoint(xs[i], highs[i]));
+            ImPlotPlot &plot = *ImPlot::GetCurrentPlot();
+            const ImPlotAxis &x = plot.Axes[plot.CurrentX];
+            CandleRenderer::Columns base{ xs, opens, closes, lows, highs };
+            // the pyramid serves the fit below and zoomed-out drawing
+            pyramid_.update(base, count, count > 1 ? xs[1] - xs[0] : 1.0, version, lineage);
+            // fit data if requested: two points spanning the extremes of the candles in view, or
+            // of all of them when x is fitted too, found without visiting the candles. A mapped
+            // file's stored pyramid answers that on its own; an index over its lows and highs
+            // would have to read the whole file first.
+            if (ImPlot::FitThisFrame() && count > 0) {
+                size_t first = 0, last = count;
+                if (!x.FitThisFrame) {
+                    first = branchlessLowerBound(xs, count, x.Range.Min);
+                    last = branchlessLowerBound(xs, count, std::nextafter(x.Range.Max, INFINITY));
+                }
+                RangeExtrema::Extent extent;
+                if (mapped) {
+                    extent = pyramid_.extent(base, first, last);
+                } else {
+                    extrema_.update(lows, highs, count, version, lineage);
+                    extent = extrema_.query(first, last);
+                }
+                if (!extent.empty()) {
+                    ImPlot::FitPoint(ImPlotPoint(xs[first], extent.low));
+                    ImPlot::FitPoint(ImPlotPoint(xs[last - 1], extent.high));
                 }
             }
             // render data
-            for (int i = 0; i < count; ++i) {
-                ImVec2 open_pos  = ImPlot::PlotToPixels(xs[i] - half_width, opens[i]);
-                ImVec2 close_pos = ImPlot::PlotToPixels(xs[i] + half_width, closes[i]);
-                ImVec2 low_pos   = ImPlot::PlotToPixels(xs[i], lows[i]);
-                ImVec2 high_pos  = ImPlot::PlotToPixels(xs[i], highs[i]);
-                ImU32 color      = ImGui::GetColorU32(opens[i] > closes[i] ? bearCol : bullCol);
-                draw_list->AddLine(low_pos, high_pos, color);
-                draw_list->AddRectFilled(open_pos, close_pos, color);
+            auto x_axis = AxisTransform::of(x);
+            auto y_axis = AxisTransform::of(plot.Axes[plot.CurrentY]);
+            if (x_axis && y_axis) {
+                // zoomed out, merged candles of a coarser level are drawn instead
+                auto lod = pyramid_.select(std::abs(x_axis->scale), kMinCandlePixels);
+                auto drawLevel = [&](size_t level, float alpha) {
+                    auto columns = level == 0 ? base : pyramid_.columns(level);
+                    double level_half_width = level == 0 ? half_width : pyramid_.spacing(level) * width_percent;
+                    // only the candles inside the x limits are transformed and emitted
+                    auto visible = VisibleRange::of(columns.xs, pyramid_.count(level), x.Range.Min, x.Range.Max, level_half_width);
+                    ImVec4 bull = bullCol, bear = bearCol;
+                    bull.w *= alpha;
+                    bear.w *= alpha;
+                    candle_renderer_.draw(*draw_list, *x_axis, *y_axis, columns.from(visible.first), visible.size(),
+                                          level_half_width, ImGui::GetColorU32(bull), ImGui::GetColorU32(bear));
+                };
+                indicator_level_ = lod.finer_alpha >= 0.5f ? lod.level - 1 : lod.level;
+                if (lod.finer_alpha < 1.0f)
+                    drawLevel(lod.level, 1.0f - lod.finer_alpha);
+                if (lod.finer_alpha > 0.0f)
+                    drawLevel(lod.level - 1, lod.finer_alpha);
+            } else {
+                indicator_level_ = 0;
+                auto visible = VisibleRange::of(xs, count, x.Range.Min, x.Range.Max, half_width);
+                size_t first = visible.first;
+                drawCandlesScalar(draw_list, xs + first, opens + first, closes + first, lows + first, highs + first,
+                                  static_cast<int>(visible.size()), half_width, bullCol, bearCol);
             }
 
             // end plot item
@@ -487,6 +1468,135 @@ private:
         }
     }
 
+    // Overlays the indicators of the pyramid level the candles are drawn from, so they follow the
+    // bars on screen (a 20 bar average of weekly bars when zoomed out to weeks) and cost the same
+    // at any zoom. Every level keeps its own indicators, brought up to date as bars come in; only
+    // the visible part is plotted. volumes belong to the base level and may be null.
+    //
+    // A mapped file is not read from its start: its indicators are computed from kIndicatorLead
+    // bars before the view on. Moving windows only need a period of those, and EMA and RSI have
+    // long forgotten where they started by the time the view begins. The window snaps to multiples
+    // of the lead, so panning only recomputes it when the view crosses one.
+    void plotIndicators(std::span<const double> x_span, std::span<const double> open_span, std::span<const double> close_span, std::span<const double> low_span, std::span<const double> high_span, const double* volumes, bool mapped) {
+        if (x_span.empty())
+            return;
+        size_t level = indicator_level_;
+        CandleRenderer::Columns columns = level == 0 ? CandleRenderer::Columns{ x_span.data(), open_span.data(), close_span.data(), low_span.data(), high_span.data() } : pyramid_.columns(level);
+        size_t count = level == 0 ? x_span.size() : pyramid_.count(level);
+        ImPlotRect limits = ImPlot::GetPlotLimits();
+        auto visible = VisibleRange::of(columns.xs, count, limits.X.Min, limits.X.Max, 0.0);
+        size_t begin = 0, end = count;
+        if (mapped) {
+            begin = visible.first / kIndicatorLead * kIndicatorLead;
+            begin = begin > kIndicatorLead ? begin - kIndicatorLead : 0;
+            end = std::min(count, (visible.last + kIndicatorLead - 1) / kIndicatorLead * kIndicatorLead);
+        }
+        if (indicators_.size() <= level)
+            indicators_.resize(level + 1);
+        IndicatorSet &set = indicators_[level];
+        set.update(columns.from(begin), end - begin, level == 0 && volumes ? volumes + begin : nullptr);
+
+        // from here on indices are into the window
+        const double *xs = columns.xs + begin;
+        visible = { .first = visible.first - begin, .last = visible.last - begin };
+        auto line = [&](const char* label, const double* ys, size_t warmup) {
+            size_t first = std::max(visible.first, warmup);
+            if (first < visible.last)
+                ImPlot::PlotLine(label, xs + first, ys + first, static_cast<int>(visible.last - first));
+        };
+        line("SMA", set.sma(), set.smaWarmup());
+        line("EMA", set.ema(), set.emaWarmup());
+        line("VWAP", set.vwap(), set.vwapWarmup());
+        // the band is shaded and outlined under one legend entry
+        size_t first = std::max(visible.first, set.bollingerWarmup());
+        if (first < visible.last) {
+            int n = static_cast<int>(visible.last - first);
+            ImPlot::SetNextFillStyle(IMPLOT_AUTO_COL, 0.15f);
+            ImPlot::PlotShaded("Bollinger", xs + first, set.bollingerUpper() + first, set.bollingerLower() + first, n);
+            ImPlot::PlotLine("Bollinger", xs + first, set.bollingerUpper() + first, n);
+            ImPlot::PlotLine("Bollinger", xs + first, set.bollingerLower() + first, n);
+        }
+        ImPlot::SetAxes(ImAxis_X1, ImAxis_Y2);
+        line("RSI", set.rsi(), set.rsiWarmup());
+        ImPlot::SetAxes(ImAxis_X1, ImAxis_Y1);
+    }
+
+    // A strip of the whole history's closes under the chart with the chart's range marked,
+    // downsampled to one point per pixel so it costs the same however long the history is. A
+    // mapped file is downsampled from the finest pyramid level with at most kOverviewOversample
+    // bars per pixel instead, so the strip never reads the base candles of a long history.
+    void plotOverview(std::span<const double> xs, std::span<const double> closes, uint64_t version, bool mapped) {
+        size_t budget = static_cast<size_t>(std::max(ImGui::GetContentRegionAvail().x, 3.0f));
+        if (mapped) {
+            size_t level = 0;
+            while (level + 1 < pyramid_.levels() && pyramid_.count(level) > kOverviewOversample * budget)
+                ++level;
+            if (level > 0) {
+                auto columns = pyramid_.columns(level);
+                xs = { columns.xs, pyramid_.count(level) };
+                closes = { columns.closes, pyramid_.count(level) };
+            }
+        }
+        if (ImPlot::BeginPlot("##Overview", ImVec2(-1,kStripHeight), ImPlotFlags_CanvasOnly)) {
+            ImPlot::SetupAxes(nullptr,nullptr,ImPlotAxisFlags_NoDecorations|ImPlotAxisFlags_AutoFit,ImPlotAxisFlags_NoDecorations|ImPlotAxisFlags_AutoFit);
+            const auto &points = overview_.downsample(xs, closes, version, budget);
+            ImPlot::PlotLine("##Close", points.xs.data(), points.ys.data(), static_cast<int>(points.size()));
+            // the candlestick chart's view
+            ImPlotRect limits = ImPlot::GetPlotLimits();
+            ImVec2 view_min = ImPlot::PlotToPixels(visible_min_, limits.Y.Max);
+            ImVec2 view_max = ImPlot::PlotToPixels(visible_max_, limits.Y.Min);
+            ImPlot::PushPlotClipRect();
+            ImPlot::GetPlotDrawList()->AddRectFilled(view_min, view_max, IM_COL32(128,128,128,64));
+            ImPlot::PopPlotClipRect();
+            ImPlot::EndPlot();
+        }
+    }
+
+    // Order book depth of the live feed beside the chart, over the chart's price range. Only the
+    // columns added since the last frame are uploaded.
+    void plotDepth(float height) {
+        LiveFeed &feed = *live_;
+        feed.depth.upload();
+        if (ImPlot::BeginPlot("Depth", ImVec2(-1,height), ImPlotFlags_NoLegend|ImPlotFlags_NoMenus)) {
+            double end = feed.book.columnsEnd();
+            double history = feed.depth.columns() * feed.book.interval();
+            ImPlot::SetupAxes(nullptr,nullptr,ImPlotAxisFlags_NoTickLabels,ImPlotAxisFlags_NoTickLabels);
+            ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Time);
+            ImPlot::SetupAxisLimits(ImAxis_X1, end - history, end, ImPlotCond_Always);
+            ImPlot::SetupAxisLimits(ImAxis_Y1, visible_low_, visible_high_, ImPlotCond_Always);
+            if (feed.book.started() && feed.depth.filled() > 0) {
+                // u runs past 1 once the ring has wrapped; the texture repeats
+                auto [u0, u1] = feed.depth.u();
+                double begin = end - feed.depth.filled() * feed.book.interval();
+                ImPlot::PlotImage("##Depth", feed.depth.texture(), ImPlotPoint(begin, feed.book.low()), ImPlotPoint(end, feed.book.high()), ImVec2(u0, 1), ImVec2(u1, 0));
+            }
+            ImPlot::EndPlot();
+        }
+    }
+
+    // The latest trades of the live feed, plotted straight from the ring through ImPlot's offset.
+    void plotTrades() {
+        const auto &trades = live_->trades;
+        if (ImPlot::BeginPlot("##Trades", ImVec2(-1,kStripHeight), ImPlotFlags_CanvasOnly)) {
+            ImPlot::SetupAxes(nullptr,nullptr,ImPlotAxisFlags_NoDecorations|ImPlotAxisFlags_AutoFit,ImPlotAxisFlags_NoTickLabels|ImPlotAxisFlags_AutoFit);
+            ImPlot::PlotLine("##Trades", trades.xs(), trades.ys(), static_cast<int>(trades.size()), 0, trades.offset());
+            ImPlot::EndPlot();
+        }
+    }
+
+    // Fallback for axes with a non-linear scale, which have to go through ImPlot's transform.
+    void drawCandlesScalar(ImDrawList* draw_list, const double* xs, const double* opens, const double* closes, const double* lows, const double* highs, int count, double half_width, ImVec4 bullCol, ImVec4 bearCol) {
+        for (int i = 0; i < count; ++i) {
+            ImVec2 open_pos  = ImPlot::PlotToPixels(xs[i] - half_width, opens[i]);
+            ImVec2 close_pos = ImPlot::PlotToPixels(xs[i] + half_width, closes[i]);
+            ImVec2 low_pos   = ImPlot::PlotToPixels(xs[i], lows[i]);
+            ImVec2 high_pos  = ImPlot::PlotToPixels(xs[i], highs[i]);
+            ImU32 color      = ImGui::GetColorU32(opens[i] > closes[i] ? bearCol : bullCol);
+            draw_list->AddLine(low_pos, high_pos, color);
+            draw_list->AddRectFilled(open_pos, close_pos, color);
+        }
+    }
+
     struct State {
         int width = -1;
         int height = -1;
@@ -495,13 +1605,174 @@ private:
     State state_;
 
     ImPlotContext *ctx_;
+    OhlcSeries series_;
+    // of an imported series_, if its file has them
+    std::vector<double> volumes_;
+    std::unique_ptr<MappedOhlcFile> file_;
+    std::unique_ptr<OhlcCsvImporter> importer_;
+    // see writeImport(); declared after what it reads, so destruction waits for it first
+    std::future<std::unique_ptr<MappedOhlcFile>> conversion_;
+    std::shared_ptr<SceneInvalidation> invalidation_ = std::make_shared<SceneInvalidation>();
+    int import_percent_ = -1;
+    std::string label_ = "GOOGL";
+    // lineage of the series the axes were last framed for
+    uint64_t placed_lineage_ = 0;
+    std::unique_ptr<LiveFeed> live_;
+    double visible_min_ = 0.0;
+    double visible_max_ = 0.0;
+    double visible_low_ = 0.0;
+    double visible_high_ = 0.0;
+    CandleRenderer candle_renderer_;
+    OhlcPyramid pyramid_;
+    RangeExtrema extrema_;
+    std::vector<IndicatorSet> indicators_;
+    LttbDownsampler overview_;
+    size_t indicator_level_ = 0;
+    // candles closer than this are drawn from a coarser pyramid level
+    static constexpr float kMinCandlePixels = 4.0f;
+    // ten times the longest indicator period, see plotIndicators()
+    static constexpr size_t kIndicatorLead = 500;
+    static constexpr double kMinZoomBars = 20.0;
+    static constexpr size_t kOverviewOversample = 4;
+    static constexpr float kStripHeight = 80.0f;
+    static constexpr float kDepthWidth = 240.0f;
 };
 
+class SceneSignal
+{
+public:
+    // build() only reads the samples, which never change, and its own decimation cache.
+    static constexpr bool kThreadSafeBuild = true;
+
+    // A noisy chirp with rare spikes, SLINT_IMGUI_SIGNAL_SAMPLES samples long (10M by default),
+    // so the spikes show whether decimation keeps every extreme.
+    SceneSignal()
+    {
+        size_t count = 10'000'000;
+        if (const char *samples = std::getenv("SLINT_IMGUI_SIGNAL_SAMPLES"))
+            count = std::max<size_t>(1, std::strtoull(samples, nullptr, 10));
+        samples_.resize(count);
+        uint64_t noise = 0x9e3779b97f4a7c15;
+        for (size_t i = 0; i < count; ++i) {
+            double t = static_cast<double>(i) / kSampleRate;
+            noise ^= noise << 13;
+            noise ^= noise >> 7;
+            noise ^= noise << 17;
+            double jitter = static_cast<double>(noise >> 11) * 0x1p-53 - 0.5;
+            samples_[i] = std::sin(t * (1.0 + t * 0.01)) + 0.1 * jitter + (noise % 1'000'003 == 0 ? 3.0 : 0.0);
+        }
+    }
+
+    void setup() {
+        ctx_ = ImPlot::CreateContext();
+    }
+
+    void teardown() {
+        ImPlot::DestroyContext(ctx_);
+        ctx_ = nullptr;
+    }
+
+    void bind(slint::ComponentHandle<App> &app)
+    {
+        app->on_requested_texture_size_changed([invalidation = invalidation_]() { invalidation->invalidate(); });
+    }
+
+    SceneInvalidation &invalidation() { return *invalidation_; }
+
+    bool needsUpdate(slint::ComponentHandle<App> &app)
+    {
+        auto new_state = State{
+            .width = app->get_requested_texture_width(),
+            .height = app->get_requested_texture_height()
+        };
+        if (state_.width != new_state.width || state_.height != new_state.height) {
+            state_ = new_state;
+            return true;
+        }
+        return false;
+    }
+
+    void build([[maybe_unused]] slint::ComponentHandle<App> &app)
+    {
+        ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+        if (ImGui::Begin("Signal", nullptr, ImGuiWindowFlags_NoSavedSettings)) {
+            double duration = static_cast<double>(samples_.size() - 1) / kSampleRate;
+            ImGui::Text("%zu of %zu samples plotted", plotted_, samples_.size());
+            if (ImPlot::BeginPlot("Signal", ImVec2(-1,-1))) {
+                ImPlot::SetupAxes("time (s)", nullptr, 0, ImPlotAxisFlags_AutoFit|ImPlotAxisFlags_RangeFit);
+                ImPlot::SetupAxisLimits(ImAxis_X1, 0, duration, ImPlotCond_Once);
+                // the axis transform has to be final before decimating for it
+                ImPlot::SetupFinish();
+                ImPlotPlot &plot = *ImPlot::GetCurrentPlot();
+                const ImPlotAxis &x = plot.Axes[plot.CurrentX];
+                // the decimated line only covers the view, so a fit of x is fed the whole extent
+                if (x.FitThisFrame) {
+                    ImPlot::FitPoint(ImPlotPoint(0, samples_.front()));
+                    ImPlot::FitPoint(ImPlotPoint(duration, samples_.back()));
+                }
+                if (auto x_axis = AxisTransform::of(x)) {
+                    const auto &line = decimator_.decimateUniform(0.0, 1.0 / kSampleRate, samples_, 0, *x_axis, x.PixelMin, x.PixelMax);
+                    ImPlot::PlotLine("samples", line.xs.data(), line.ys.data(), static_cast<int>(line.size()));
+                    plotted_ = line.size();
+                }
+                ImPlot::EndPlot();
+            }
+        }
+        ImGui::End();
+    }
+
+private:
+    static constexpr double kSampleRate = 1000.0;
+
+    struct State {
+        int width = -1;
+        int height = -1;
+    };
+
+    State state_;
+    std::shared_ptr<SceneInvalidation> invalidation_ = std::make_shared<SceneInvalidation>();
+    ImPlotContext *ctx_ = nullptr;
+    std::vector<double> samples_;
+    M4Decimator decimator_;
+    size_t plotted_ = 0;
+};
+
+// Renderer options switched on from the environment: SLINT_IMGUI_WORKER renders on a GL worker
+// thread, SLINT_IMGUI_ADAPTIVE=<frame budget in ms> lowers the resolution of slow frames during
+// gestures and SLINT_IMGUI_DRAW_TO_WINDOW draws straight into Slint's framebuffer.
+static ImGuiRendererOptions rendererOptions()
+{
+    ImGuiRendererOptions options;
+    options.render_on_worker_thread = std::getenv("SLINT_IMGUI_WORKER") != nullptr;
+    options.draw_to_window = std::getenv("SLINT_IMGUI_DRAW_TO_WINDOW") != nullptr;
+    if (const char *budget = std::getenv("SLINT_IMGUI_ADAPTIVE")) {
+        options.adaptive_resolution = true;
+        if (double ms = std::atof(budget); ms > 0.0)
+            options.frame_budget = std::chrono::microseconds(static_cast<int64_t>(ms * 1000.0));
+    }
+    return options;
+}
+
+// SLINT_IMGUI_SCENE picks the scene: demo (the default), implot or signal.
+static std::optional<slint::SetRenderingNotifierError> setSceneRenderer(slint::ComponentHandle<App> &app)
+{
+    std::string_view scene = std::getenv("SLINT_IMGUI_SCENE") ? std::getenv("SLINT_IMGUI_SCENE") : "demo";
+    ImGuiRendererOptions options = rendererOptions();
+    if (scene == "implot")
+        return app->window().set_rendering_notifier(ImGuiRenderer<SceneImPlot>(app, options));
+    if (scene == "signal")
+        return app->window().set_rendering_notifier(ImGuiRenderer<SceneSignal>(app, options));
+    if (scene != "demo")
+        println(stderr, "Unknown scene {}, showing the demo (SLINT_IMGUI_SCENE=demo|implot|signal)", scene);
+    return app->window().set_rendering_notifier(ImGuiRenderer<SceneDemo>(app, options));
+}
+
 int main()
 {
     auto app = App::create();
 
-    if (auto error = app->window().set_rendering_notifier(ImGuiRenderer<SceneDemo>(app))) {
+    if (auto error = setSceneRenderer(app)) {
         if (*error == slint::SetRenderingNotifierError::Unsupported) {
             println(stderr, "This example requires the use of a GL renderer. Please run with the "
                             "environment variable SLINT_BACKEND=winit-femtovg set.");
@@ -0,0 +1,40 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+
+// lower_bound over sorted doubles that always runs ceil(log2(count)) iterations and picks the
+// next half with a conditional move instead of a branch, so the outcome of each comparison is
+// never mispredicted. Both candidate midpoints of the next step are prefetched while the current
+// one is compared, which hides most of the cache misses on large series.
+inline size_t branchlessLowerBound(const double *xs, size_t count, double value)
+{
+    if (count == 0)
+        return 0;
+    const double *base = xs;
+    size_t n = count;
+    while (n > 1) {
+        size_t half = n / 2;
+        __builtin_prefetch(base + half / 2);
+        __builtin_prefetch(base + half + half / 2);
+        base = base[half] < value ? base + half : base;
+        n -= half;
+    }
+    return static_cast<size_t>(base - xs) + (*base < value);
+}
+
+// Index of the element of sorted xs closest to value; ties go to the earlier one.
+inline std::optional<size_t> nearestIndex(const double *xs, size_t count, double value)
+{
+    if (count == 0)
+        return std::nullopt;
+    size_t i = branchlessLowerBound(xs, count, value);
+    if (i == count)
+        return count - 1;
+    if (i > 0 && value - xs[i - 1] <= xs[i] - value)
+        return i - 1;
+    return i;
+}
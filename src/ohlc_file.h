@@ -0,0 +1,292 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <print>
+#include <span>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ohlc_pyramid.h"
+#include "ohlc_series.h"
+
+// Columnar OHLC file, meant to be mapped rather than parsed. Layout, native little-endian:
+//
+//   OhlcFileHeader
+//   OhlcFileLevel[header.lod_levels]    merged pyramid levels, coarser ones last
+//   column data                         every column starts on a 64-byte boundary
+//
+// The base series has timestamp, open, high, low, close and volume columns of header.count
+// doubles each; every level has timestamp, open, high, low and close columns of its own count.
+// Offsets are in bytes from the start of the file. A volume offset of 0 means the file has no
+// volumes.
+//
+// Timestamps are strictly increasing, in the base series and in every level. Levels are what
+// OhlcPyramid builds, and readers rely on its bucket grid: a level's spacing is one of
+// OhlcPyramid::kPeriods, larger than the level before it, and its bars merge the base candles of
+// one bucket [kOrigin + k * spacing, kOrigin + (k + 1) * spacing) each, with x inside the bucket.
+// open() checks the spacings; the bars are trusted.
+static_assert(std::endian::native == std::endian::little, "OHLC files are little-endian");
+
+struct OhlcFileHeader
+{
+    static constexpr std::array<char, 8> kMagic = { 'O', 'H', 'L', 'C', 'C', 'O', 'L', 0 };
+    static constexpr uint32_t kVersion = 1;
+
+    enum Column { X, Open, High, Low, Close, Volume, ColumnCount };
+
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t lod_levels;
+    uint64_t count;
+    double spacing;
+    std::array<uint64_t, ColumnCount> columns;
+};
+
+struct OhlcFileLevel
+{
+    double spacing;
+    uint64_t count;
+    std::array<uint64_t, OhlcFileHeader::Volume> columns;
+};
+
+// Writes series (and volumes, none when empty) plus the merged levels of lod, if given, whose
+// level 0 has to be series itself. Returns false and reports on stderr when writing fails.
+inline bool writeOhlcFile(const char *path, const OhlcSeries &series, std::span<const double> volumes,
+                          const OhlcPyramid *lod)
+{
+    constexpr uint64_t kAlignment = 64;
+    auto align = [](uint64_t offset) { return (offset + kAlignment - 1) / kAlignment * kAlignment; };
+
+    OhlcFileHeader header = {};
+    header.magic = OhlcFileHeader::kMagic;
+    header.version = OhlcFileHeader::kVersion;
+    header.lod_levels = lod ? static_cast<uint32_t>(lod->levels() - 1) : 0;
+    header.count = series.size();
+    header.spacing = lod ? lod->spacing(0) : series.size() > 1 ? series.xs()[1] - series.xs()[0] : 1.0;
+
+    if (!volumes.empty() && volumes.size() != series.size()) {
+        std::println(stderr, "Cannot write {}: {} volumes for {} bars", path, volumes.size(), series.size());
+        return false;
+    }
+
+    // Every column to write, in file order, with its offset filled in as the layout is laid out.
+    std::vector<std::pair<const double *, uint64_t *>> columns;
+    std::vector<uint64_t> counts;
+    auto add = [&](const double *data, uint64_t *offset, uint64_t count) {
+        columns.emplace_back(data, offset);
+        counts.push_back(count);
+    };
+    add(series.xs().data(), &header.columns[OhlcFileHeader::X], header.count);
+    add(series.opens().data(), &header.columns[OhlcFileHeader::Open], header.count);
+    add(series.highs().data(), &header.columns[OhlcFileHeader::High], header.count);
+    add(series.lows().data(), &header.columns[OhlcFileHeader::Low], header.count);
+    add(series.closes().data(), &header.columns[OhlcFileHeader::Close], header.count);
+    if (!volumes.empty())
+        add(volumes.data(), &header.columns[OhlcFileHeader::Volume], header.count);
+
+    std::vector<OhlcFileLevel> levels(header.lod_levels);
+    for (size_t i = 0; i < levels.size(); ++i) {
+        auto source = lod->columns(i + 1);
+        levels[i].spacing = lod->spacing(i + 1);
+        levels[i].count = lod->count(i + 1);
+        add(source.xs, &levels[i].columns[OhlcFileHeader::X], levels[i].count);
+        add(source.opens, &levels[i].columns[OhlcFileHeader::Open], levels[i].count);
+        add(source.highs, &levels[i].columns[OhlcFileHeader::High], levels[i].count);
+        add(source.lows, &levels[i].columns[OhlcFileHeader::Low], levels[i].count);
+        add(source.closes, &levels[i].columns[OhlcFileHeader::Close], levels[i].count);
+    }
+
+    uint64_t offset = sizeof(OhlcFileHeader) + levels.size() * sizeof(OhlcFileLevel);
+    for (size_t i = 0; i < columns.size(); ++i) {
+        offset = align(offset);
+        *columns[i].second = offset;
+        offset += counts[i] * sizeof(double);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(levels.data()), levels.size() * sizeof(OhlcFileLevel));
+    for (size_t i = 0; i < columns.size(); ++i) {
+        static constexpr char kPadding[kAlignment] = {};
+        out.write(kPadding, static_cast<std::streamsize>(*columns[i].second - static_cast<uint64_t>(out.tellp())));
+        out.write(reinterpret_cast<const char *>(columns[i].first), counts[i] * sizeof(double));
+    }
+    if (!out) {
+        std::println(stderr, "Cannot write {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// A read-only mapping of an OHLC file. Columns point straight into the mapping, so opening a
+// file costs the same whatever its size; pages are faulted in as they are first read. SceneImPlot
+// reads base candles only around the view (the candles drawn, a lead of a few hundred bars for
+// the indicators, the partial buckets at the edges of a y fit, binary searches) and takes the
+// rest from the stored levels. A file without them is read in full once to build them.
+class MappedOhlcFile
+{
+public:
+    // Returns nullptr, after reporting why on stderr, unless path is a valid OHLC file.
+    static std::unique_ptr<MappedOhlcFile> open(const char *path)
+    {
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            std::println(stderr, "Cannot open {}: {}", path, std::strerror(errno));
+            return nullptr;
+        }
+        struct stat st = {};
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(OhlcFileHeader)) {
+            std::println(stderr, "{} is not an OHLC file", path);
+            ::close(fd);
+            return nullptr;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            std::println(stderr, "Cannot map {}: {}", path, std::strerror(errno));
+            return nullptr;
+        }
+
+        std::unique_ptr<MappedOhlcFile> file(new MappedOhlcFile(static_cast<const std::byte *>(data), size));
+        if (!file->valid()) {
+            std::println(stderr, "{} is not a version {} OHLC file, is truncated or has levels off the pyramid's periods", path,
+                         OhlcFileHeader::kVersion);
+            return nullptr;
+        }
+        return file;
+    }
+
+    MappedOhlcFile(const MappedOhlcFile &) = delete;
+    MappedOhlcFile &operator=(const MappedOhlcFile &) = delete;
+
+    ~MappedOhlcFile() { munmap(const_cast<std::byte *>(data_), size_); }
+
+    size_t size() const { return header().count; }
+    bool empty() const { return size() == 0; }
+    double spacing() const { return header().spacing; }
+    // Mapped files never change.
+    uint64_t version() const { return 0; }
+    uint64_t lineage() const { return lineage_; }
+
+    std::span<const double> xs() const { return column(OhlcFileHeader::X); }
+    std::span<const double> opens() const { return column(OhlcFileHeader::Open); }
+    std::span<const double> highs() const { return column(OhlcFileHeader::High); }
+    std::span<const double> lows() const { return column(OhlcFileHeader::Low); }
+    std::span<const double> closes() const { return column(OhlcFileHeader::Close); }
+    // Empty, with a null data(), when the file has no volumes.
+    std::span<const double> volumes() const
+    {
+        return hasVolumes() ? column(OhlcFileHeader::Volume) : std::span<const double>();
+    }
+
+    // The stored pyramid levels, ready for OhlcPyramid::adopt().
+    std::vector<OhlcPyramid::Precomputed> lod() const
+    {
+        std::vector<OhlcPyramid::Precomputed> levels;
+        for (const OhlcFileLevel &level : fileLevels()) {
+            levels.push_back({ .spacing = level.spacing,
+                               .count = level.count,
+                               .columns = { at(level.columns[OhlcFileHeader::X]),
+                                            at(level.columns[OhlcFileHeader::Open]),
+                                            at(level.columns[OhlcFileHeader::Close]),
+                                            at(level.columns[OhlcFileHeader::Low]),
+                                            at(level.columns[OhlcFileHeader::High]) } });
+        }
+        return levels;
+    }
+
+    // Whether the file holds series, its volumes and the merged levels of pyramid bit for bit, as
+    // written by writeOhlcFile(); reads all of it.
+    bool holds(const OhlcSeries &series, std::span<const double> volumes, const OhlcPyramid *pyramid) const
+    {
+        auto same = [](std::span<const double> a, std::span<const double> b) {
+            return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size_bytes()) == 0);
+        };
+        if (!same(xs(), series.xs()) || !same(opens(), series.opens()) || !same(highs(), series.highs())
+            || !same(lows(), series.lows()) || !same(closes(), series.closes()) || !same(this->volumes(), volumes))
+            return false;
+
+        auto levels = lod();
+        if (levels.size() != (pyramid ? pyramid->levels() - 1 : 0))
+            return false;
+        for (size_t i = 0; i < levels.size(); ++i) {
+            auto stored = levels[i].columns, expected = pyramid->columns(i + 1);
+            size_t count = pyramid->count(i + 1);
+            if (levels[i].spacing != pyramid->spacing(i + 1) || levels[i].count != count)
+                return false;
+            for (auto [a, b] : { std::pair{ stored.xs, expected.xs }, std::pair{ stored.opens, expected.opens },
+                                 std::pair{ stored.highs, expected.highs }, std::pair{ stored.lows, expected.lows },
+                                 std::pair{ stored.closes, expected.closes } })
+                if (!same({ a, count }, { b, count }))
+                    return false;
+        }
+        return true;
+    }
+
+private:
+    MappedOhlcFile(const std::byte *data, size_t size) : data_(data), size_(size) { }
+
+    const OhlcFileHeader &header() const { return *reinterpret_cast<const OhlcFileHeader *>(data_); }
+
+    bool hasVolumes() const { return header().columns[OhlcFileHeader::Volume] != 0; }
+
+    std::span<const OhlcFileLevel> fileLevels() const
+    {
+        return { reinterpret_cast<const OhlcFileLevel *>(data_ + sizeof(OhlcFileHeader)), header().lod_levels };
+    }
+
+    const double *at(uint64_t offset) const { return reinterpret_cast<const double *>(data_ + offset); }
+
+    std::span<const double> column(OhlcFileHeader::Column column) const
+    {
+        return { at(header().columns[column]), header().count };
+    }
+
+    // Column offsets must be aligned and in bounds and level spacings on the pyramid's grid (see
+    // the format above); only the header and level table are read.
+    bool valid() const
+    {
+        const OhlcFileHeader &h = header();
+        if (h.magic != OhlcFileHeader::kMagic || h.version != OhlcFileHeader::kVersion)
+            return false;
+        if (h.lod_levels > (size_ - sizeof(OhlcFileHeader)) / sizeof(OhlcFileLevel))
+            return false;
+        auto fits = [this](uint64_t offset, uint64_t count) {
+            return offset % alignof(double) == 0 && offset <= size_ && count <= (size_ - offset) / sizeof(double);
+        };
+        for (size_t column = 0; column < h.columns.size(); ++column)
+            if ((column != OhlcFileHeader::Volume || hasVolumes()) && !fits(h.columns[column], h.count))
+                return false;
+        double spacing = 0.0;
+        for (const OhlcFileLevel &level : fileLevels()) {
+            const auto &periods = OhlcPyramid::kPeriods;
+            if (!(level.spacing > spacing) || std::ranges::find(periods, level.spacing) == periods.end())
+                return false;
+            spacing = level.spacing;
+            for (uint64_t offset : level.columns)
+                if (!fits(offset, level.count))
+                    return false;
+        }
+        return true;
+    }
+
+    const std::byte *data_;
+    size_t size_;
+    uint64_t lineage_ = newSeriesLineage();
+};
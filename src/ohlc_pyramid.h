@@ -0,0 +1,283 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "candle_renderer.h"
+#include "nearest_index.h"
+#include "range_extrema.h"
+
+// Coarser copies of an OHLC series for drawing it zoomed out. Every level merges the base candles
+// that fall into the same time bucket (first open, highest high, lowest low, last close); bucket
+// periods nest (5m, 1h, 1d, 1w, 4w, 16w, all aligned to Monday 1970-01-05), so a bar never
+// straddles two bars of a coarser level. Level 0 is the caller's own series and is not copied.
+//
+// A growing series is caught up with rather than rebuilt: appended candles and a revised last one
+// only change the last merged bar of every level and add new ones after it. Which periods get a
+// level depends on the number of candles, so that choice is made again by a full build whenever
+// the series has doubled since, which keeps the cost per appended candle constant on average.
+class OhlcPyramid
+{
+public:
+    static constexpr double kOrigin = 4 * 86400.0;
+    static constexpr std::array<double, 6> kPeriods = { 300.0,    3600.0,    86400.0,
+                                                        604800.0, 2419200.0, 9676800.0 };
+
+    // What to draw for the current zoom: level, faded out by (1 - finer_alpha), under the next
+    // finer level, faded in by finer_alpha. Zooming moves the alpha continuously, and by the
+    // time a level takes over it is already drawn fully opaque, so nothing pops.
+    struct Selection
+    {
+        size_t level;
+        float finer_alpha;
+    };
+
+    // A merged level computed elsewhere, e.g. stored next to the series in a file.
+    struct Precomputed
+    {
+        double spacing;
+        size_t count;
+        CandleRenderer::Columns columns;
+    };
+
+    // Rebuilds the merged levels, skipping periods that would not at least halve the number of
+    // candles of the level below. base_spacing is the x distance between base candles; version
+    // and lineage are the series' (see OhlcSeries), if it has them.
+    void build(const CandleRenderer::Columns &base, size_t count, double base_spacing, uint64_t version = 0,
+               uint64_t lineage = 0)
+    {
+        reset(base.xs, count, base_spacing, version, lineage);
+        built_count_ = count;
+
+        size_t previous_count = count;
+        for (double period : kPeriods) {
+            if (period <= levels_.back().spacing)
+                continue;
+            Level level;
+            level.spacing = period;
+            merge(level, base, count);
+            if (level.xs.size() * 2 > previous_count)
+                continue;
+            previous_count = level.xs.size();
+            levels_.push_back(std::move(level));
+        }
+    }
+
+    // Brings built levels up to date with the first count candles of base. Within a lineage
+    // candles may only have been appended or the last one revised since the previous call;
+    // anything else, adopted levels and a series that doubled since the last build() rebuild.
+    void update(const CandleRenderer::Columns &base, size_t count, double base_spacing, uint64_t version,
+                uint64_t lineage)
+    {
+        if (builtFor(base.xs, count, version, lineage))
+            return;
+        if (levels_.empty() || adopted_ || lineage != base_lineage_ || count < base_count_
+            || count >= 2 * built_count_) {
+            build(base, count, base_spacing, version, lineage);
+            return;
+        }
+        setBase(base.xs, count, version, lineage);
+        for (size_t l = 1; l < levels_.size(); ++l)
+            merge(levels_[l], base, count);
+    }
+
+    // Uses merged levels computed elsewhere instead of building them. Nothing is copied, so the
+    // level memory has to stay valid for as long as the pyramid is used with this series.
+    void adopt(const double *xs, size_t count, double base_spacing, std::span<const Precomputed> levels,
+               uint64_t version = 0, uint64_t lineage = 0)
+    {
+        reset(xs, count, base_spacing, version, lineage);
+        adopted_ = true;
+        for (const Precomputed &precomputed : levels) {
+            Level &level = levels_.emplace_back();
+            level.spacing = precomputed.spacing;
+            level.count = precomputed.count;
+            level.columns = precomputed.columns;
+        }
+    }
+
+    // Cheap identity check of the series the pyramid was built from. The version catches the
+    // forming last bar of a live series changing in place.
+    bool builtFor(const double *xs, size_t count, uint64_t version = 0, uint64_t lineage = 0) const
+    {
+        if (levels_.empty() || count != base_count_ || version != base_version_ || lineage != base_lineage_)
+            return false;
+        return count == 0 || (xs[0] == base_first_ && xs[count - 1] == base_last_);
+    }
+
+    size_t levels() const { return levels_.size(); }
+
+    double spacing(size_t level) const { return levels_[level].spacing; }
+
+    // Level 0 is the base series and has to come from the caller.
+    CandleRenderer::Columns columns(size_t level) const { return levels_[level].columns; }
+
+    size_t count(size_t level) const { return level == 0 ? base_count_ : levels_[level].count; }
+
+    // Picks the finest level whose candles are at least min_pixels apart. The level below it
+    // fades in over the last halving of the zoom before it qualifies itself.
+    Selection select(double pixels_per_unit, float min_pixels) const
+    {
+        size_t level = 0;
+        while (level + 1 < levels_.size() && levels_[level].spacing * pixels_per_unit < min_pixels)
+            ++level;
+        if (level == 0)
+            return { .level = 0, .finer_alpha = 0.0f };
+
+        double finer_pixels = levels_[level - 1].spacing * pixels_per_unit;
+        float alpha = static_cast<float>((finer_pixels - 0.5 * min_pixels) / (0.5 * min_pixels));
+        return { .level = level, .finer_alpha = std::clamp(alpha, 0.0f, 1.0f) };
+    }
+
+    // Lowest low and highest high of base candles [first, last) of the series the pyramid was
+    // built from. Whole buckets of the coarsest level inside the range are read from its merged
+    // bars, the partial buckets at either end from the next finer level and so on down to the base
+    // candles, so a query reads a few bars per level however long the range is. Unlike
+    // RangeExtrema nothing is built over the base candles, which keeps a mapped series unread.
+    RangeExtrema::Extent extent(const CandleRenderer::Columns &base, size_t first, size_t last) const
+    {
+        return extentFrom(levels_.size() - 1, base, first, last);
+    }
+
+private:
+    // The merged bar the next candles may still go into: its first candle and the extremes of
+    // its candles so far.
+    struct OpenBar
+    {
+        size_t begin = 0;
+        double high = -std::numeric_limits<double>::infinity();
+        double low = std::numeric_limits<double>::infinity();
+    };
+
+    // Built levels own their columns; adopted ones only point at them.
+    struct Level
+    {
+        double spacing = 0.0;
+        size_t count = 0;
+        OpenBar open;
+        size_t settled = 0; // candles merged for good, see merge()
+        CandleRenderer::Columns columns = {};
+        std::vector<double> xs;
+        std::vector<double> opens;
+        std::vector<double> closes;
+        std::vector<double> lows;
+        std::vector<double> highs;
+    };
+
+    void reset(const double *xs, size_t count, double base_spacing, uint64_t version, uint64_t lineage)
+    {
+        levels_.clear();
+        levels_.emplace_back().spacing = base_spacing;
+        adopted_ = false;
+        setBase(xs, count, version, lineage);
+    }
+
+    void setBase(const double *xs, size_t count, uint64_t version, uint64_t lineage)
+    {
+        base_version_ = version;
+        base_lineage_ = lineage;
+        base_count_ = count;
+        base_first_ = count > 0 ? xs[0] : 0.0;
+        base_last_ = count > 0 ? xs[count - 1] : 0.0;
+    }
+
+    // extent() from levels up to l.
+    RangeExtrema::Extent extentFrom(size_t l, const CandleRenderer::Columns &base, size_t first, size_t last) const
+    {
+        RangeExtrema::Extent extent;
+        if (first >= last)
+            return extent;
+        if (l == 0) {
+            for (size_t i = first; i < last; ++i) {
+                extent.low = std::min(extent.low, base.lows[i]);
+                extent.high = std::max(extent.high, base.highs[i]);
+            }
+            return extent;
+        }
+
+        // buckets [whole_begin, whole_end) lie entirely inside the range
+        const Level &level = levels_[l];
+        auto bucket = [&](size_t i) { return std::floor((base.xs[i] - kOrigin) / level.spacing); };
+        double whole_begin = bucket(first), whole_end = bucket(last - 1);
+        if (first > 0 && bucket(first - 1) == whole_begin)
+            whole_begin += 1;
+        if (last == base_count_ || bucket(last) != whole_end)
+            whole_end += 1;
+        if (whole_begin >= whole_end)
+            return extentFrom(l - 1, base, first, last);
+
+        double begin_x = kOrigin + whole_begin * level.spacing, end_x = kOrigin + whole_end * level.spacing;
+        extent = extentFrom(l - 1, base, first, branchlessLowerBound(base.xs, base_count_, begin_x));
+        auto tail = extentFrom(l - 1, base, branchlessLowerBound(base.xs, base_count_, end_x), last);
+        extent = { .low = std::min(extent.low, tail.low), .high = std::max(extent.high, tail.high) };
+        // merged bars sit inside their bucket
+        const auto &bars = level.columns;
+        size_t end = branchlessLowerBound(bars.xs, level.count, end_x);
+        for (size_t j = branchlessLowerBound(bars.xs, level.count, begin_x); j < end; ++j) {
+            extent.low = std::min(extent.low, bars.lows[j]);
+            extent.high = std::max(extent.high, bars.highs[j]);
+        }
+        return extent;
+    }
+
+    // Merges base candles [level.settled, count) into the level. The bar they start in is the
+    // level's last one, which gets replaced; its candles before settled are summed up in
+    // level.open. The last candle may still be revised, so the open bar's sum stops short of it.
+    // Merged bars sit halfway between the first and last base candle they cover.
+    static void merge(Level &level, const CandleRenderer::Columns &base, size_t count)
+    {
+        if (count == 0)
+            return;
+        const double period = level.spacing;
+        auto bucket = [&](size_t i) { return std::floor((base.xs[i] - kOrigin) / period); };
+        if (!level.xs.empty()) {
+            for (std::vector<double> *column : { &level.xs, &level.opens, &level.closes, &level.lows, &level.highs })
+                column->pop_back();
+        }
+
+        OpenBar bar = level.open;
+        auto emit = [&](size_t end) {
+            level.xs.push_back(0.5 * (base.xs[bar.begin] + base.xs[end - 1]));
+            level.opens.push_back(base.opens[bar.begin]);
+            level.closes.push_back(base.closes[end - 1]);
+            level.lows.push_back(bar.low);
+            level.highs.push_back(bar.high);
+        };
+        for (size_t i = level.settled; i < count; ++i) {
+            if (i > bar.begin && bucket(i) != bucket(bar.begin)) {
+                emit(i);
+                bar = { .begin = i };
+            }
+            if (i + 1 == count) {
+                level.open = bar;
+                level.settled = i;
+            }
+            bar.high = std::max(bar.high, base.highs[i]);
+            bar.low = std::min(bar.low, base.lows[i]);
+        }
+        emit(count);
+
+        level.count = level.xs.size();
+        level.columns = { level.xs.data(), level.opens.data(), level.closes.data(), level.lows.data(),
+                          level.highs.data() };
+    }
+
+    std::vector<Level> levels_;
+    size_t base_count_ = 0;
+    double base_first_ = 0.0;
+    double base_last_ = 0.0;
+    uint64_t base_version_ = 0;
+    uint64_t base_lineage_ = 0;
+    // candles at the last build(), see update()
+    size_t built_count_ = 0;
+    bool adopted_ = false;
+};
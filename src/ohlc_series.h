@@ -0,0 +1,163 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <vector>
+
+// Allocates on Alignment-byte boundaries, so column starts line up with cache lines and full
+// vector registers.
+template<typename T, size_t Alignment>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &)
+    {
+    }
+
+    T *allocate(size_t n) { return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{ Alignment })); }
+
+    void deallocate(T *p, size_t) { ::operator delete(p, std::align_val_t{ Alignment }); }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const
+    {
+        return true;
+    }
+};
+
+// Identifies a history of bars that only ever grows at the end: caches derived from bars of the
+// same lineage only have to catch up with the bars appended since, and with the last bar they saw,
+// which may have been revised. Unique within the process.
+inline uint64_t newSeriesLineage()
+{
+    static std::atomic<uint64_t> next = 1;
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+// OHLC bars stored column by column (structure of arrays), sorted by time. Owned outside the
+// frame loop; scenes plot straight from the columns, so a frame does no data setup at all.
+// version() changes with every modification, for caches derived from the series; lineage()
+// changes with every modification other than appending and revising the last bar.
+class OhlcSeries
+{
+public:
+    static constexpr size_t kAlignment = 64;
+    using Column = std::vector<double, AlignedAllocator<double, kAlignment>>;
+
+    OhlcSeries() = default;
+    OhlcSeries(OhlcSeries &&) = default;
+    OhlcSeries &operator=(OhlcSeries &&) = default;
+    // a copy grows independently of the original
+    OhlcSeries(const OhlcSeries &other) : OhlcSeries() { *this = other; }
+    OhlcSeries &operator=(const OhlcSeries &other)
+    {
+        xs_ = other.xs_;
+        opens_ = other.opens_;
+        highs_ = other.highs_;
+        lows_ = other.lows_;
+        closes_ = other.closes_;
+        ++version_;
+        lineage_ = newSeriesLineage();
+        return *this;
+    }
+
+    size_t size() const { return xs_.size(); }
+    bool empty() const { return xs_.empty(); }
+    uint64_t version() const { return version_; }
+    uint64_t lineage() const { return lineage_; }
+
+    std::span<const double> xs() const { return xs_; }
+    std::span<const double> opens() const { return opens_; }
+    std::span<const double> highs() const { return highs_; }
+    std::span<const double> lows() const { return lows_; }
+    std::span<const double> closes() const { return closes_; }
+
+    void reserve(size_t count)
+    {
+        for (Column *column : columns())
+            column->reserve(count);
+    }
+
+    // Bars have to arrive in time order.
+    void append(double x, double open, double high, double low, double close)
+    {
+        assert(xs_.empty() || x >= xs_.back());
+        xs_.push_back(x);
+        opens_.push_back(open);
+        highs_.push_back(high);
+        lows_.push_back(low);
+        closes_.push_back(close);
+        ++version_;
+    }
+
+    // Revises the last bar, which is still forming.
+    void updateBack(double high, double low, double close)
+    {
+        assert(!xs_.empty());
+        highs_.back() = high;
+        lows_.back() = low;
+        closes_.back() = close;
+        ++version_;
+    }
+
+    // Appends whole columns at once; all spans must have the same size.
+    void append(std::span<const double> xs, std::span<const double> opens, std::span<const double> highs,
+                std::span<const double> lows, std::span<const double> closes)
+    {
+        assert(opens.size() == xs.size() && highs.size() == xs.size() && lows.size() == xs.size()
+               && closes.size() == xs.size());
+        assert(xs.empty() || xs_.empty() || xs.front() >= xs_.back());
+        xs_.insert(xs_.end(), xs.begin(), xs.end());
+        opens_.insert(opens_.end(), opens.begin(), opens.end());
+        highs_.insert(highs_.end(), highs.begin(), highs.end());
+        lows_.insert(lows_.end(), lows.begin(), lows.end());
+        closes_.insert(closes_.end(), closes.begin(), closes.end());
+        ++version_;
+    }
+
+    // Replaces the contents with the given columns.
+    void load(std::span<const double> xs, std::span<const double> opens, std::span<const double> highs,
+              std::span<const double> lows, std::span<const double> closes)
+    {
+        clear();
+        reserve(xs.size());
+        append(xs, opens, highs, lows, closes);
+    }
+
+    void clear()
+    {
+        for (Column *column : columns())
+            column->clear();
+        ++version_;
+        lineage_ = newSeriesLineage();
+    }
+
+private:
+    std::array<Column *, 5> columns() { return { &xs_, &opens_, &highs_, &lows_, &closes_ }; }
+
+    Column xs_;
+    Column opens_;
+    Column highs_;
+    Column lows_;
+    Column closes_;
+    uint64_t version_ = 0;
+    uint64_t lineage_ = newSeriesLineage();
+};
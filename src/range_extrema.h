@@ -0,0 +1,111 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Lowest low and highest high of any index range of a series, for fitting the y axis to the
+// visible candles without visiting them. The series is cut into blocks of kBlock bars; a sparse
+// table over the block extrema answers the whole blocks of a query with two lookups, and only the
+// partial blocks at either end are scanned, so a query touches at most 2 * kBlock bars whatever
+// the range. The table takes (count / kBlock) * log2(count / kBlock) pairs, a few MB for 10M bars.
+//
+// A growing series is caught up with rather than rebuilt: only complete blocks are in the table,
+// so an appended or revised last bar changes at most the last complete block and adds new ones,
+// and each of those is in a single entry per table level.
+class RangeExtrema
+{
+public:
+    static constexpr size_t kBlock = 64;
+
+    struct Extent
+    {
+        double low = std::numeric_limits<double>::infinity();
+        double high = -std::numeric_limits<double>::infinity();
+
+        bool empty() const { return low > high; }
+    };
+
+    // Brings the table up to date with the first count bars. Within a lineage (see OhlcSeries)
+    // bars may only have been appended or the last one revised since the previous call; anything
+    // else rebuilds. lows and highs are read again by queries and have to stay valid until the
+    // next update.
+    void update(const double *lows, const double *highs, size_t count, uint64_t version, uint64_t lineage)
+    {
+        bool extend = lineage == lineage_ && count >= count_;
+        if (extend && lows == lows_ && count == count_ && version == version_)
+            return;
+        size_t changed = extend && count_ > 0 ? (count_ - 1) / kBlock : 0;
+        lows_ = lows;
+        highs_ = highs;
+        count_ = count;
+        version_ = version;
+        lineage_ = lineage;
+        if (!extend)
+            levels_.clear();
+
+        size_t blocks = count / kBlock;
+        if (blocks == 0 || changed >= blocks)
+            return;
+        // Entries of level k cover 2^k blocks, so the ones covering a changed block start at
+        // most 2^k - 1 blocks before it; entries past the level's previous end are new.
+        size_t width = 1;
+        for (size_t k = 0; width <= blocks; ++k, width *= 2) {
+            if (levels_.size() == k)
+                levels_.emplace_back();
+            auto &level = levels_[k];
+            size_t first = std::min(level.size(), changed >= width - 1 ? changed - (width - 1) : 0);
+            level.resize(blocks - width + 1);
+            for (size_t b = first; b < level.size(); ++b)
+                level[b] = k == 0 ? scan(b * kBlock, (b + 1) * kBlock)
+                                  : merge(levels_[k - 1][b], levels_[k - 1][b + width / 2]);
+        }
+    }
+
+    // Extent of the bars [first, last); empty() when the range is.
+    Extent query(size_t first, size_t last) const
+    {
+        assert(first <= last && last <= count_);
+        size_t head_end = (first + kBlock - 1) / kBlock * kBlock;
+        size_t tail_begin = last / kBlock * kBlock;
+        if (head_end >= tail_begin)
+            return scan(first, last);
+
+        Extent extent = merge(scan(first, head_end), scan(tail_begin, last));
+        size_t begin = head_end / kBlock, end = tail_begin / kBlock;
+        const auto &level = levels_[std::bit_width(end - begin) - 1];
+        size_t width = size_t(1) << (std::bit_width(end - begin) - 1);
+        return merge(extent, merge(level[begin], level[end - width]));
+    }
+
+private:
+    static Extent merge(const Extent &a, const Extent &b)
+    {
+        return { .low = std::min(a.low, b.low), .high = std::max(a.high, b.high) };
+    }
+
+    Extent scan(size_t first, size_t last) const
+    {
+        Extent extent;
+        for (size_t i = first; i < last; ++i) {
+            extent.low = std::min(extent.low, lows_[i]);
+            extent.high = std::max(extent.high, highs_[i]);
+        }
+        return extent;
+    }
+
+    const double *lows_ = nullptr;
+    const double *highs_ = nullptr;
+    size_t count_ = 0;
+    uint64_t version_ = 0;
+    uint64_t lineage_ = 0;
+    // levels_[k][b] covers blocks [b, b + 2^k)
+    std::vector<std::vector<Extent>> levels_;
+};
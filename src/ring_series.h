@@ -0,0 +1,61 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// The latest Capacity samples of a live line, stored column by column in fixed arrays that are
+// overwritten oldest first. The columns are laid out the way ImPlot's offset argument expects
+// (sample i is at (offset() + i) % size()), so a scroll plot passes them straight to PlotLine and
+// neither pushing nor plotting ever copies or allocates.
+//
+// Not synchronized: samples are pushed from the thread that plots them, between frames, e.g.
+// from needsUpdate() while draining a queue filled by the actual producer.
+template<size_t Capacity>
+class RingSeries
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    static constexpr size_t kAlignment = 64;
+
+    void push(double x, double y)
+    {
+        size_t slot = pushed_ & (Capacity - 1);
+        xs_[slot] = x;
+        ys_[slot] = y;
+        ++pushed_;
+    }
+
+    size_t size() const { return std::min<uint64_t>(pushed_, Capacity); }
+    bool empty() const { return pushed_ == 0; }
+
+    // Counts every sample ever pushed, so it only grows; unchanged means nothing new to plot.
+    uint64_t version() const { return pushed_; }
+
+    // Position of the oldest sample in the columns, ImPlot's offset argument.
+    int offset() const { return pushed_ < Capacity ? 0 : static_cast<int>(pushed_ & (Capacity - 1)); }
+
+    const double *xs() const { return xs_.data(); }
+    const double *ys() const { return ys_.data(); }
+
+    // The i-th oldest sample.
+    double x(size_t i) const { return xs_[slot(i)]; }
+    double y(size_t i) const { return ys_[slot(i)]; }
+
+private:
+    size_t slot(size_t i) const
+    {
+        assert(i < size());
+        return (static_cast<size_t>(offset()) + i) & (Capacity - 1);
+    }
+
+    alignas(kAlignment) std::array<double, Capacity> xs_;
+    alignas(kAlignment) std::array<double, Capacity> ys_;
+    uint64_t pushed_ = 0;
+};
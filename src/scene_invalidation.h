@@ -0,0 +1,53 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+// The generation of everything an ImGui scene is built from. Whatever changes one of its inputs
+// calls invalidate(): Slint change callbacks of the properties the scene reads, and data sources
+// as they deliver, from any thread. The renderer compares generation() with the generation it
+// last built from, a single load per frame however many inputs the scene has, and asks the scene
+// what changed only when it moved.
+//
+// The first invalidation after the renderer last looked also wakes it, so changes that arrive
+// while nothing else is drawing still get a frame; further ones fold into that wake-up.
+class SceneInvalidation
+{
+public:
+    void invalidate()
+    {
+        generation_.fetch_add(1);
+        if (wake_pending_.exchange(true))
+            return;
+        std::lock_guard lock(mutex_);
+        if (wake_)
+            wake_();
+    }
+
+    // Re-arms the wake-up before reading, so an invalidation racing with it wakes again; only the
+    // renderer the wake-up goes to calls this.
+    uint64_t generation()
+    {
+        wake_pending_.store(false);
+        return generation_.load();
+    }
+
+    // How to wake the renderer; called on whichever thread invalidates.
+    void wakeWith(std::function<void()> wake)
+    {
+        std::lock_guard lock(mutex_);
+        wake_ = std::move(wake);
+    }
+
+private:
+    std::atomic<uint64_t> generation_ = 0;
+    std::atomic<bool> wake_pending_ = false;
+    std::mutex mutex_;
+    std::function<void()> wake_;
+};
@@ -0,0 +1,255 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "gl_state.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <GLES3/gl3.h>
+
+struct SceneTexture
+{
+    GLuint texture;
+    int width;
+    int height;
+    GLuint fbo;
+
+    SceneTexture(int width, int height) : width(width), height(height)
+    {
+        glGenFramebuffers(1, &fbo);
+        glGenTextures(1, &texture);
+
+        ScopedTextureBinding activeTexture(texture);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        // No pixel data is uploaded, so the GL_UNPACK_* state is irrelevant here.
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     nullptr);
+
+        ScopedFrameBufferBinding activeFBO(fbo);
+
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+        assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+    }
+    SceneTexture(const SceneTexture &) = delete;
+    SceneTexture &operator=(const SceneTexture &) = delete;
+    ~SceneTexture()
+    {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(1, &texture);
+        glStateCache().onFramebufferDeleted(fbo);
+        glStateCache().onTextureDeleted(texture);
+    }
+
+    template<std::invocable<> Callback>
+    void with_active_fbo(Callback callback)
+    {
+        ScopedFrameBufferBinding activeFBO(fbo);
+        callback();
+    }
+
+    bool fits(int w, int h) const { return width >= w && height >= h; }
+    size_t size_in_bytes() const { return size_t(width) * size_t(height) * 4; }
+};
+
+// Recycles SceneTextures across size changes. Sizes are rounded up to whole buckets and the
+// scene is drawn into the bottom-left width x height corner, so a live resize keeps reusing the
+// texture it already has (or one left over from earlier in the drag) instead of reallocating
+// on every layout pass.
+class SceneTexturePool
+{
+public:
+    static constexpr int kBucketSize = 256;
+
+    explicit SceneTexturePool(size_t budget_bytes) : budget_bytes_(budget_bytes) { }
+
+    static int bucket(int size)
+    {
+        return std::max(1, (size + kBucketSize - 1) / kBucketSize) * kBucketSize;
+    }
+
+    // Hands out the smallest idle texture that fits, allocating a bucket-sized one otherwise.
+    // With exact set, only a texture of exactly the bucket size is reused.
+    std::unique_ptr<SceneTexture> acquire(int width, int height, bool exact = false)
+    {
+        int bucket_width = bucket(width);
+        int bucket_height = bucket(height);
+
+        auto best = idle_.end();
+        for (auto it = idle_.begin(); it != idle_.end(); ++it) {
+            const SceneTexture &candidate = **it;
+            bool usable = exact ? candidate.width == bucket_width && candidate.height == bucket_height
+                                : candidate.fits(width, height);
+            if (usable && (best == idle_.end() || candidate.size_in_bytes() < (*best)->size_in_bytes()))
+                best = it;
+        }
+        if (best != idle_.end()) {
+            auto texture = std::move(*best);
+            idle_.erase(best);
+            return texture;
+        }
+
+        auto texture = std::make_unique<SceneTexture>(bucket_width, bucket_height);
+        allocated_bytes_ += texture->size_in_bytes();
+        return texture;
+    }
+
+    void release(std::unique_ptr<SceneTexture> texture)
+    {
+        if (texture)
+            idle_.push_back(std::move(texture));
+    }
+
+    // Frees idle textures, least recently released first, until everything allocated through
+    // the pool (handed out or idle) fits within the budget.
+    void trim()
+    {
+        while (allocated_bytes_ > budget_bytes_ && !idle_.empty()) {
+            allocated_bytes_ -= idle_.front()->size_in_bytes();
+            idle_.erase(idle_.begin());
+        }
+    }
+
+    void clear()
+    {
+        for (const auto &texture : idle_)
+            allocated_bytes_ -= texture->size_in_bytes();
+        idle_.clear();
+    }
+
+    size_t allocated_bytes() const { return allocated_bytes_; }
+
+private:
+    size_t budget_bytes_;
+    size_t allocated_bytes_ = 0;
+    std::vector<std::unique_ptr<SceneTexture>> idle_;
+};
+
+// Fixed ring of render targets handed to Slint as borrowed textures.
+// A slot is drawn into again only once the fence inserted after the last Slint frame that
+// sampled it has signaled, so ImGui never renders into a texture the compositor may still be
+// reading and the driver never has to serialize the two behind our back.
+class SceneTextureRing
+{
+public:
+    static constexpr size_t kSize = 3;
+
+    explicit SceneTextureRing(size_t pool_budget) : pool_(pool_budget) { }
+
+    // Returns the texture to draw the next frame into, able to hold width x height. With shrink
+    // set, an oversized texture is exchanged for an exactly bucket-sized one.
+    SceneTexture &acquire(int width, int height, bool shrink)
+    {
+        next_ = pickSlot();
+        auto &texture = slots_[next_].texture;
+        if (!texture || !texture->fits(width, height)
+            || (shrink && isOversized(*texture, width, height))) {
+            auto replacement = pool_.acquire(width, height, shrink);
+            pool_.release(std::exchange(texture, std::move(replacement)));
+        }
+        return *texture;
+    }
+
+    // What Slint currently shows, or nullptr before the first present().
+    SceneTexture *displayed() { return slots_[displayed_].texture.get(); }
+
+    // The texture handed out by the last acquire() is the one Slint displays from now on.
+    void present() { displayed_ = next_; }
+
+    // Called once Slint has issued the commands of a frame that sampled the displayed texture.
+    void fenceDisplayed()
+    {
+        Slot &slot = slots_[displayed_];
+        if (!slot.texture)
+            return;
+        if (slot.fence)
+            glDeleteSync(slot.fence);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    bool hasOversized(int width, int height) const
+    {
+        return std::ranges::any_of(slots_, [&](const Slot &slot) {
+            return slot.texture && isOversized(*slot.texture, width, height);
+        });
+    }
+
+    void trim() { pool_.trim(); }
+
+    void clear()
+    {
+        for (Slot &slot : slots_) {
+            if (slot.fence)
+                glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+            pool_.release(std::move(slot.texture));
+        }
+        pool_.clear();
+    }
+
+    // Time acquire() spent blocked on fences since the last call.
+    std::chrono::nanoseconds takeStallTime() { return std::exchange(stall_time_, {}); }
+
+    static bool isOversized(const SceneTexture &texture, int width, int height)
+    {
+        return texture.width > SceneTexturePool::bucket(width)
+                || texture.height > SceneTexturePool::bucket(height);
+    }
+
+private:
+    struct Slot
+    {
+        std::unique_ptr<SceneTexture> texture;
+        GLsync fence = nullptr;
+    };
+
+    static constexpr GLuint64 kWaitSliceNs = 100'000'000;
+
+    // Takes the least recently displayed slot whose fence has already signaled, and only blocks
+    // (on the oldest one) when every candidate is still in flight.
+    size_t pickSlot()
+    {
+        for (size_t i = 1; i < kSize; ++i) {
+            size_t index = (displayed_ + i) % kSize;
+            if (waitFence(slots_[index], 0))
+                return index;
+        }
+
+        size_t oldest = (displayed_ + 1) % kSize;
+        auto start = std::chrono::steady_clock::now();
+        while (!waitFence(slots_[oldest], kWaitSliceNs)) { }
+        stall_time_ += std::chrono::steady_clock::now() - start;
+        return oldest;
+    }
+
+    static bool waitFence(Slot &slot, GLuint64 timeout_ns)
+    {
+        if (!slot.fence)
+            return true;
+        if (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns) == GL_TIMEOUT_EXPIRED)
+            return false;
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        return true;
+    }
+
+    SceneTexturePool pool_;
+    std::array<Slot, kSize> slots_;
+    size_t displayed_ = 0;
+    size_t next_ = 0;
+    std::chrono::nanoseconds stall_time_{};
+};
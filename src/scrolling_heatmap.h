@@ -0,0 +1,123 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "gl_state.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <GLES3/gl3.h>
+
+#include "imgui.h"
+
+// A heatmap scrolling in time, one column per time step, kept in a GL texture used as a circular
+// buffer: a new column overwrites the oldest one in place with a one texel wide glTexSubImage2D,
+// so the upload per step is a single column however much history is shown. The texture repeats
+// horizontally, and drawing it with u running from the oldest column to one texture width further
+// unrolls the ring into time order on a single quad.
+//
+// push() colours columns on the CPU and may run on any thread the scene state belongs to;
+// upload() and release() need the GL context, i.e. have to be called from build() and
+// teardown(); the texture is not released on destruction, where there is no context. Columns
+// are sampled with nearest filtering, so the seam never blends the newest column into the oldest.
+class ScrollingHeatmap
+{
+public:
+    ScrollingHeatmap(int columns, int rows) : columns_(columns), rows_(rows) { assert(columns > 0 && rows > 0); }
+
+    ScrollingHeatmap(const ScrollingHeatmap &) = delete;
+    ScrollingHeatmap &operator=(const ScrollingHeatmap &) = delete;
+
+    int columns() const { return columns_; }
+    int rows() const { return rows_; }
+
+    // Appends a column of rows values in [0, 1], bottom row first. Columns not uploaded yet that
+    // would be overwritten before they could be seen are dropped right away.
+    void push(std::span<const float> values)
+    {
+        assert(values.size() == static_cast<size_t>(rows_));
+        std::vector<uint32_t> column(rows_);
+        std::ranges::transform(values, column.begin(), colour);
+        pending_.push_back(std::move(column));
+        if (pending_.size() > static_cast<size_t>(columns_))
+            pending_.pop_front();
+        ++pushed_;
+    }
+
+    // Creates the texture on first use and uploads the columns pushed since the last call.
+    void upload()
+    {
+        if (pending_.empty())
+            return;
+        if (texture_ == 0)
+            create();
+        ScopedTextureBinding bound(texture_);
+        ScopedPixelStore row_length(GL_UNPACK_ROW_LENGTH, 0);
+        ScopedPixelStore alignment(GL_UNPACK_ALIGNMENT, 4);
+        // columns dropped in push() are skipped, their slots are overwritten by later ones
+        uint64_t index = pushed_ - pending_.size();
+        for (const std::vector<uint32_t> &column : pending_) {
+            GLint x = static_cast<GLint>(index++ % static_cast<uint64_t>(columns_));
+            glTexSubImage2D(GL_TEXTURE_2D, 0, x, 0, 1, rows_, GL_RGBA, GL_UNSIGNED_BYTE, column.data());
+        }
+        pending_.clear();
+        uploaded_ = pushed_;
+    }
+
+    void release()
+    {
+        if (texture_ == 0)
+            return;
+        glDeleteTextures(1, &texture_);
+        glStateCache().onTextureDeleted(texture_);
+        texture_ = 0;
+    }
+
+    ImTextureID texture() const { return static_cast<ImTextureID>(texture_); }
+
+    // Number of uploaded columns that are shown, at most columns().
+    int filled() const { return static_cast<int>(std::min<uint64_t>(uploaded_, static_cast<uint64_t>(columns_))); }
+
+    // Horizontal texture coordinates spanning the shown columns oldest to newest; the right one
+    // may exceed 1 and relies on the texture repeating.
+    std::pair<float, float> u() const
+    {
+        float first = static_cast<float>((uploaded_ - static_cast<uint64_t>(filled())) % static_cast<uint64_t>(columns_));
+        return { first / columns_, (first + filled()) / columns_ };
+    }
+
+private:
+    void create()
+    {
+        glGenTextures(1, &texture_);
+        ScopedTextureBinding bound(texture_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, columns_, rows_);
+    }
+
+    // Dark blue through red to yellow, transparent where there is nothing.
+    static uint32_t colour(float value)
+    {
+        float v = std::clamp(value, 0.0f, 1.0f);
+        auto channel = [](float c) { return static_cast<int>(std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f)); };
+        return IM_COL32(channel(2.0f * v), channel(2.0f * v - 1.0f), channel(0.5f - v), channel(4.0f * v));
+    }
+
+    int columns_;
+    int rows_;
+    GLuint texture_ = 0;
+    uint64_t pushed_ = 0;
+    uint64_t uploaded_ = 0;
+    std::deque<std::vector<uint32_t>> pending_;
+};
@@ -0,0 +1,80 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of threads running jobs in submission order, each on whichever thread is free.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency())
+    {
+        threads = std::max(threads, 1u);
+        for (unsigned i = 0; i < threads; ++i)
+            threads_.emplace_back([this]() { run(); });
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Runs every job still queued, then joins the threads.
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            quit_ = true;
+        }
+        wakeup_.notify_all();
+        for (std::thread &thread : threads_)
+            thread.join();
+    }
+
+    size_t size() const { return threads_.size(); }
+
+    template<typename F>
+    std::future<std::invoke_result_t<F>> submit(F job)
+    {
+        // std::function needs a copyable callable, which packaged_task is not.
+        auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::move(job));
+        auto result = task->get_future();
+        {
+            std::lock_guard lock(mutex_);
+            jobs_.push_back([task]() { (*task)(); });
+        }
+        wakeup_.notify_one();
+        return result;
+    }
+
+private:
+    void run()
+    {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock lock(mutex_);
+                wakeup_.wait(lock, [this]() { return quit_ || !jobs_.empty(); });
+                if (jobs_.empty())
+                    return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::deque<std::function<void()>> jobs_;
+    bool quit_ = false;
+    std::vector<std::thread> threads_;
+};
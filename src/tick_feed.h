@@ -0,0 +1,234 @@
+// Copyright © YanivZeg <https://github.com/YanivZeg>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "ohlc_series.h"
+
+// One trade.
+struct Tick
+{
+    double time; // Unix seconds
+    double price;
+    double volume;
+};
+
+// Keeps the producer and consumer indices of the ring below on separate cache lines.
+inline constexpr size_t kCacheLine = 64;
+
+// Bounded lock-free queue for exactly one producer and one consumer thread. Capacity is a power
+// of two so positions wrap with a mask; storage is inline, nothing allocates after construction.
+template<typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side. Returns false when the ring is full.
+    bool tryPush(const T &value)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == Capacity) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == Capacity)
+                return false;
+        }
+        slots_[tail & (Capacity - 1)] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Hands every queued value to consume, returns how many there were.
+    template<typename F>
+    size_t consumeAll(F consume)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        for (size_t i = head; i != tail; ++i)
+            consume(slots_[i & (Capacity - 1)]);
+        head_.store(tail, std::memory_order_release);
+        return tail - head;
+    }
+
+private:
+    alignas(kCacheLine) std::atomic<size_t> head_ = 0;
+    alignas(kCacheLine) std::atomic<size_t> tail_ = 0;
+    size_t cached_head_ = 0; // producer's last view of head_
+    alignas(kCacheLine) std::array<T, Capacity> slots_;
+};
+
+// Folds ticks into bars of a fixed period, stamped with the start of their period like the daily
+// bars of the sample. Ticks have to arrive in time order.
+class BarAggregator
+{
+public:
+    explicit BarAggregator(double period) : period_(period) { }
+
+    double period() const { return period_; }
+
+    // Returns the index of the bar the tick went into, the last one of the series.
+    size_t add(OhlcSeries &series, const Tick &tick)
+    {
+        double start = std::floor(tick.time / period_) * period_;
+        if (!series.empty() && series.xs().back() == start) {
+            size_t last = series.size() - 1;
+            series.updateBack(std::max(series.highs()[last], tick.price), std::min(series.lows()[last], tick.price),
+                              tick.price);
+        } else {
+            series.append(start, tick.price, tick.price, tick.price, tick.price);
+        }
+        return series.size() - 1;
+    }
+
+private:
+    double period_;
+};
+
+// Local stand-in for order book depth snapshots, derived from the trades: resting liquidity on a
+// fixed price grid that thins out away from the last trade, plus whatever traded at each level,
+// one column of levels per interval. Columns are normalized to [0, 1] for display. The grid is
+// centred on the first trade and does not follow the price afterwards.
+class SyntheticOrderBook
+{
+public:
+    SyntheticOrderBook(int levels, double tick_size, double interval)
+        : tick_size_(tick_size), interval_(interval), resting_(levels), traded_(levels), column_(levels)
+    {
+    }
+
+    int levels() const { return static_cast<int>(column_.size()); }
+    bool started() const { return std::isfinite(low_); }
+    double low() const { return low_; }
+    double high() const { return low_ + tick_size_ * levels(); }
+    double interval() const { return interval_; }
+    // End of the last column handed out.
+    double columnsEnd() const { return next_column_ - interval_; }
+
+    // Feeds a trade, first handing on_column a column for every interval that ended before it.
+    // After a long gap only the last max_columns intervals are produced.
+    template<typename F>
+    void add(const Tick &tick, size_t max_columns, F on_column)
+    {
+        if (!started()) {
+            low_ = std::round(tick.price / tick_size_ - levels() / 2.0) * tick_size_;
+            next_column_ = (std::floor(tick.time / interval_) + 1.0) * interval_;
+        }
+        if (tick.time >= next_column_) {
+            double skipped = std::floor((tick.time - next_column_) / interval_);
+            if (skipped >= static_cast<double>(max_columns))
+                next_column_ += (skipped - static_cast<double>(max_columns) + 1.0) * interval_;
+            while (tick.time >= next_column_) {
+                on_column(std::span<const float>(close()));
+                next_column_ += interval_;
+            }
+        }
+        auto level = static_cast<long>(std::floor((tick.price - low_) / tick_size_));
+        if (level >= 0 && level < levels())
+            traded_[level] += static_cast<float>(tick.volume);
+        last_price_ = tick.price;
+    }
+
+private:
+    const std::vector<float> &close()
+    {
+        float traded_max = std::max(1.0f, *std::max_element(traded_.begin(), traded_.end()));
+        for (int l = 0; l < levels(); ++l) {
+            double distance = std::abs(low_ + (l + 0.5) * tick_size_ - last_price_) / tick_size_;
+            // orders come and go a little with every snapshot
+            resting_[l] = 0.8f * resting_[l] + 0.2f * static_cast<float>(std::exp(-distance / 20.0) * jitter_(random_));
+            column_[l] = std::min(1.0f, 0.7f * resting_[l] + traded_[l] / traded_max);
+            traded_[l] = 0.0f;
+        }
+        return column_;
+    }
+
+    double tick_size_;
+    double interval_;
+    double low_ = NAN;
+    double next_column_ = 0.0;
+    double last_price_ = 0.0;
+    std::vector<float> resting_;
+    std::vector<float> traded_;
+    std::vector<float> column_;
+    std::mt19937 random_{ std::random_device{}() };
+    std::uniform_real_distribution<double> jitter_{ 0.3, 1.7 };
+};
+
+// Local stand-in for a market data feed: a thread producing a random walk of trades at a fixed
+// rate into ring, calling on_ticks (from the producer thread) after every batch it pushed. Ticks
+// that do not fit into the ring are dropped and counted.
+template<typename Ring>
+class SyntheticTickGenerator
+{
+public:
+    SyntheticTickGenerator(Ring &ring, double ticks_per_second, std::function<void()> on_ticks)
+        : ring_(ring), rate_(ticks_per_second), on_ticks_(std::move(on_ticks)), thread_([this]() { run(); })
+    {
+    }
+
+    SyntheticTickGenerator(const SyntheticTickGenerator &) = delete;
+    SyntheticTickGenerator &operator=(const SyntheticTickGenerator &) = delete;
+
+    ~SyntheticTickGenerator()
+    {
+        quit_ = true;
+        thread_.join();
+    }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::chrono::milliseconds kBatchInterval{ 4 };
+
+    void run()
+    {
+        using clock = std::chrono::steady_clock;
+        std::mt19937_64 random(std::random_device{}());
+        std::normal_distribution<double> step(0.0, 0.02);
+        std::exponential_distribution<double> size(0.01);
+        double price = 100.0;
+        auto start = clock::now();
+        // Times run on the steady clock from a single wall clock reading, so they keep increasing
+        // when the wall clock is stepped back, which BarAggregator could not take.
+        double start_time = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+        uint64_t produced = 0;
+
+        while (!quit_) {
+            auto now = clock::now();
+            double elapsed = std::chrono::duration<double>(now - start).count();
+            auto due = static_cast<uint64_t>(elapsed * rate_);
+            double time = start_time + elapsed;
+            bool pushed = false;
+            for (; produced < due; ++produced) {
+                price = std::max(0.01, price + step(random));
+                if (ring_.tryPush({ .time = time, .price = price, .volume = std::ceil(size(random)) }))
+                    pushed = true;
+                else
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (pushed && on_ticks_)
+                on_ticks_();
+            std::this_thread::sleep_for(kBatchInterval);
+        }
+    }
+
+    Ring &ring_;
+    double rate_;
+    std::function<void()> on_ticks_;
+    std::atomic<bool> quit_ = false;
+    std::atomic<uint64_t> dropped_ = 0;
+    std::thread thread_;
+};